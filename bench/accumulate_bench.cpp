@@ -0,0 +1,105 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+// Millions of Milli<Joule> meter readings added per second to a Joule total by a naive operator+ chain and by
+// CompensatedSum, PairwiseSum and ExactSum, with the relative error each total has drifted to. The error is measured
+// against ExactSum, which is the exact sum of the readings converted to Joule, correctly rounded.
+//     g++ -std=c++20 -O3 -march=native -I.. accumulate_bench.cpp -o accumulate_bench && ./accumulate_bench [readings] [passes]
+// UNITMAKER_BENCH_REQUIRES_CXX20
+
+#include "si_units.h"
+#include "unit_accumulate.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+// xorshift, so every run adds the same readings
+std::uint64_t next_random(std::uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+// best millions of additions per second of several calls of kernel
+template<typename Kernel>
+double time_rate(std::size_t additions, Kernel kernel) {
+    constexpr int trials = 5;
+    double best = 0;
+    for (int t = 0; t < trials; t++) {
+        auto start = std::chrono::steady_clock::now();
+        kernel();
+        auto stop = std::chrono::steady_clock::now();
+        best = std::max(best, static_cast<double>(additions) / std::chrono::duration<double>(stop - start).count() / 1e6);
+    }
+    return best;
+}
+
+double relative_error(double total, double reference) {
+    return std::fabs((total - reference) / reference);
+}
+
+// every reading added passes times, as weeks of a meter would be
+template<typename Accumulator>
+Joule accumulate(const std::vector<Milli<Joule>>& readings, std::size_t passes) {
+    Accumulator sum;
+    for (std::size_t p = 0; p < passes; p++) {
+        for (const Milli<Joule>& reading : readings) {
+            sum += reading;
+        }
+    }
+    return sum.total();
+}
+
+volatile double sink;
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::size_t{1} << 22;
+    const std::size_t passes = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 16;
+    std::vector<Milli<Joule>> readings(n, Milli<Joule>{0});
+    std::uint64_t state = 0x9e3779b97f4a7c15;
+    for (Milli<Joule>& reading : readings) {
+        // a few hundred millijoule a reading, with every bit of the double in use
+        reading = Milli<Joule>{100.0 + static_cast<double>(next_random(state) >> 11) * 0x1.0p-53 * 400.0};
+    }
+    const std::size_t additions = n * passes;
+    const double reference = accumulate<ExactSum<Joule>>(readings, passes).value;
+
+    std::printf("%zu readings, %zu passes, %.6f J\n", n, passes, reference);
+    std::printf("%-34s %12s %12s\n", "", "M adds/s", "rel. error");
+    Joule naive{0};
+    const double naive_rate = time_rate(additions, [&] {
+        naive = Joule{0};
+        for (std::size_t p = 0; p < passes; p++) {
+            for (const Milli<Joule>& reading : readings) {
+                naive = naive + reading;
+            }
+        }
+        sink = naive.value;
+    });
+    std::printf("%-34s %12.1f %12.2e\n", "operator+", naive_rate, relative_error(naive.value, reference));
+
+    auto row = [&]<typename Accumulator>(const char* name) {
+        Joule total{0};
+        const double rate = time_rate(additions, [&] {
+            total = accumulate<Accumulator>(readings, passes);
+            sink = total.value;
+        });
+        std::printf("%-34s %12.1f %12.2e\n", name, rate, relative_error(total.value, reference));
+    };
+    row.operator()<CompensatedSum<Joule>>("CompensatedSum");
+    row.operator()<PairwiseSum<Joule>>("PairwiseSum");
+    row.operator()<ExactSum<Joule>>("ExactSum");
+    return 0;
+}
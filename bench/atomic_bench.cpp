@@ -0,0 +1,100 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+// Millions of additions per second to one shared counter from 1 thread up to every hardware thread: a Joule behind a
+// std::mutex, AtomicUnit<Joule> and a raw std::atomic<double>, both compare-exchange loops, and AtomicUnit of int64_t
+// millijoules, a single fetch_add. Every thread adds Milli<Joule> readings, converted as they are added.
+//     g++ -std=c++20 -O3 -march=native -pthread -I.. atomic_bench.cpp -o atomic_bench && ./atomic_bench [additions per thread]
+// UNITMAKER_BENCH_REQUIRES_CXX20
+
+#include "si_units.h"
+#include "unit_atomic.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Millijoules = NumericUnit<Milli<Joule>, std::int64_t>;
+
+// best millions of additions per second of several runs of add(i) for i in [0, per_thread) on each of threads threads
+template<typename Add>
+double time_rate(unsigned threads, std::size_t per_thread, Add add) {
+    constexpr int trials = 5;
+    double best = 0;
+    for (int t = 0; t < trials; t++) {
+        std::atomic<unsigned> ready{0};
+        std::vector<std::thread> workers;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned w = 0; w < threads; w++) {
+            workers.emplace_back([&] {
+                // every thread starts adding once all have started
+                ready.fetch_add(1);
+                while (ready.load() < threads) {
+                }
+                for (std::size_t i = 0; i < per_thread; i++) {
+                    add(i);
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        auto stop = std::chrono::steady_clock::now();
+        best = std::max(best, static_cast<double>(threads * per_thread) / std::chrono::duration<double>(stop - start).count() / 1e6);
+    }
+    return best;
+}
+
+// a reading of 1 to 8 millijoule, exact in every counter
+Milli<Joule> reading(std::size_t i) {
+    return Milli<Joule>{static_cast<double>(1 + (i & 7))};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t per_thread = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::size_t{1} << 22;
+    const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+
+    std::printf("%zu additions per thread, M adds/s\n", per_thread);
+    std::printf("%-34s %12s %12s %12s %12s\n", "threads", "mutex", "AtomicUnit", "atomic<dbl>", "AtomicUnit<i>");
+    bool exact = true;
+    for (unsigned threads = 1;; threads = std::min(threads * 2, hardware)) {
+        std::mutex mutex;
+        Joule locked{0};
+        const double mutex_rate = time_rate(threads, per_thread, [&](std::size_t i) {
+            std::lock_guard<std::mutex> lock{mutex};
+            locked = locked + reading(i);
+        });
+        AtomicUnit<Joule> energy;
+        const double atomic_rate = time_rate(threads, per_thread, [&](std::size_t i) {
+            energy.fetch_add(reading(i), std::memory_order_relaxed);
+        });
+        std::atomic<double> raw{0};
+        const double raw_rate = time_rate(threads, per_thread, [&](std::size_t i) {
+            raw.fetch_add(reading(i).value * 1e-3, std::memory_order_relaxed);
+        });
+        AtomicUnit<Millijoules> millijoules;
+        const double integral_rate = time_rate(threads, per_thread, [&](std::size_t i) {
+            millijoules.fetch_add(reading(i), std::memory_order_relaxed);
+        });
+        // five trials of threads * per_thread readings averaging 4.5 millijoule
+        const std::int64_t expected = static_cast<std::int64_t>(threads * per_thread / 8 * 36 * 5);
+        exact = exact && (per_thread % 8 != 0 || millijoules.load().value == expected);
+        std::printf("%-34u %12.1f %12.1f %12.1f %12.1f\n", threads, mutex_rate, atomic_rate, raw_rate, integral_rate);
+        if (threads == hardware) {
+            break;
+        }
+    }
+    return exact ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+// Compression ratio and GB/s of raw samples through encode_units and decode_units on four telemetry streams: mains
+// Volt in steps of 1/8 V, noisy Ampere readings in hundredths, whole Pascal that a barometer refreshes every 16
+// samples, and int64 Milli<Second> timestamps a second apart with occasional jitter. Each stream is decoded both as
+// its own unit and converted to another, the conversion applied inside the decode loop.
+//     g++ -std=c++20 -O3 -march=native -I.. codec_bench.cpp -o codec_bench && ./codec_bench
+// UNITMAKER_BENCH_REQUIRES_CXX20
+
+#include "si_units.h"
+#include "unit_codec.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+using Milliseconds = NumericUnit<Milli<Second>, std::int64_t>;
+
+constexpr std::size_t samples = std::size_t{1} << 20;
+constexpr std::size_t block_samples = std::size_t{1} << 12;
+
+// xorshift, so every run encodes the same streams
+std::uint64_t next_random(std::uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+// best GB/s of several calls of kernel over bytes of samples
+template<typename Kernel>
+double time_rate(std::size_t bytes, Kernel kernel) {
+    constexpr int trials = 5;
+    double best = 0;
+    for (int t = 0; t < trials; t++) {
+        auto start = std::chrono::steady_clock::now();
+        kernel();
+        auto stop = std::chrono::steady_clock::now();
+        best = std::max(best, static_cast<double>(bytes) / std::chrono::duration<double>(stop - start).count() / 1e9);
+    }
+    return best;
+}
+
+volatile double sink;
+
+// one block per block_samples, then every block decoded as From and as To
+template<typename From, typename To>
+bool report(const char* name, const std::vector<From>& stream) {
+    const std::size_t bytes = stream.size() * sizeof(From);
+    std::vector<std::byte> blocks;
+    const double encoded = time_rate(bytes, [&] {
+        blocks.clear();
+        for (std::size_t i = 0; i < stream.size(); i += block_samples) {
+            encode_units(std::span<const From>{stream}.subspan(i, std::min(block_samples, stream.size() - i)), blocks);
+        }
+    });
+    std::vector<From> same(stream.size(), From{0});
+    std::vector<To> converted(stream.size(), To{0});
+    bool valid = true;
+    auto decode = [&]<typename U>(std::vector<U>& out) {
+        std::span<const std::byte> rest{blocks};
+        for (std::size_t i = 0; !rest.empty(); ) {
+            const UnitDecodeResult r = decode_units(rest, std::span<U>{out}.subspan(i));
+            valid = valid && r;
+            i += r.values;
+            rest = r ? rest.subspan(r.consumed) : std::span<const std::byte>{};
+        }
+        sink = static_cast<double>(out.back().value);
+    };
+    const double decoded = time_rate(bytes, [&] {
+        decode(same);
+    });
+    const double decoded_as = time_rate(bytes, [&] {
+        decode(converted);
+    });
+    std::printf("%-22s %8.2f %12.3f %12.3f %12.3f\n", name, static_cast<double>(bytes) / blocks.size(), encoded,
+            decoded, decoded_as);
+    return valid && std::equal(stream.begin(), stream.end(), same.begin(), [](const From& a, const From& b) {
+        return a.value == b.value;
+    });
+}
+
+} // namespace
+
+int main() {
+    std::uint64_t state = 0x9e3779b97f4a7c15;
+    std::vector<Volt> volts(samples, Volt{0});
+    std::vector<Ampere> amps(samples, Ampere{0});
+    std::vector<Pascal> pressure(samples, Pascal{0});
+    std::vector<Milliseconds> times(samples, Milliseconds{0});
+    double barometer = 101325;
+    std::int64_t now = 1600000000000;
+    for (std::size_t i = 0; i < samples; i++) {
+        const std::uint64_t r = next_random(state);
+        // 230 V rms sampled at 50 samples per cycle, in steps of 2^-3 V
+        const double counts = std::round((325.0 * std::sin(2 * 3.141592653589793 * static_cast<double>(i) / 50.0)) * 8.0
+                + static_cast<double>(r % 3) - 1.0);
+        volts[i] = Volt{counts / 8.0};
+        amps[i] = Ampere{static_cast<double>(1200 + (r >> 40) % 200) / 100.0};
+        if (i % 16 == 0) {
+            barometer += static_cast<double>((r >> 20) % 21) - 10.0;
+        }
+        pressure[i] = Pascal{barometer};
+        now += 1000 + (r % 64 == 0 ? static_cast<std::int64_t>((r >> 8) % 41) - 20 : 0);
+        times[i] = Milliseconds{now};
+    }
+
+    std::printf("%zu samples per stream, %zu per block\n", samples, block_samples);
+    std::printf("%-22s %8s %12s %12s %12s\n", "", "ratio", "encode GB/s", "decode GB/s", "converted");
+    bool valid = report<Volt, Milli<Volt>>("Volt -> mV", volts);
+    valid = report<Ampere, Milli<Ampere>>("Ampere -> mA", amps) && valid;
+    valid = report<Pascal, Kilo<Pascal>>("Pascal -> kPa", pressure) && valid;
+    valid = report<Milliseconds, Second>("int64 ms -> Second", times) && valid;
+    return valid ? 0 : 1;
+}
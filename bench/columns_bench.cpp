@@ -0,0 +1,139 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+// GB/s of a column of Meter values saved and loaded through UnitColumnWriter and UnitColumnFile, next to the same
+// values printed with fprintf and read back with strtod. The span of a stored Meter column is the mapped file itself,
+// so loading costs the sum over it; a Foot view of the same column converts as it is read, either one value at a time
+// or in bulk through copy_to.
+//     g++ -std=c++20 -O3 -march=native -I.. columns_bench.cpp -o columns_bench && ./columns_bench [values]
+// UNITMAKER_BENCH_REQUIRES_CXX20
+
+#include "si_units.h"
+#include "unit_columns.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+
+// xorshift, so every run saves the same values
+std::uint64_t next_random(std::uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+// best GB/s of several calls of kernel over bytes of values
+template<typename Kernel>
+double time_rate(std::size_t bytes, Kernel kernel) {
+    constexpr int trials = 5;
+    double best = 0;
+    for (int t = 0; t < trials; t++) {
+        auto start = std::chrono::steady_clock::now();
+        kernel();
+        auto stop = std::chrono::steady_clock::now();
+        best = std::max(best, static_cast<double>(bytes) / std::chrono::duration<double>(stop - start).count() / 1e9);
+    }
+    return best;
+}
+
+volatile double sink;
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::size_t{1} << 22;
+    const std::filesystem::path directory = std::filesystem::temp_directory_path();
+    const std::string binary = (directory / "unitmaker_columns_bench.units").string();
+    const std::string text = (directory / "unitmaker_columns_bench.txt").string();
+    const std::size_t bytes = count * sizeof(double);
+
+    std::vector<Meter> depth(count, Meter{0});
+    std::uint64_t state = 0x9e3779b97f4a7c15;
+    for (Meter& m : depth) {
+        m = Meter{static_cast<double>(next_random(state) >> 11) * 0x1.0p-53 * 4000.0};
+    }
+
+    UnitColumnError saved = UnitColumnError::NONE;
+    const double written = time_rate(bytes, [&] {
+        UnitColumnWriter writer;
+        writer.add("depth", depth);
+        saved = writer.write(binary.c_str());
+    });
+
+    const double printed = time_rate(bytes, [&] {
+        std::FILE* f = std::fopen(text.c_str(), "w");
+        for (const Meter& m : depth) {
+            std::fprintf(f, "%.17g\n", m.value);
+        }
+        std::fclose(f);
+    });
+
+    std::size_t loaded = 0;
+    const double mapped = time_rate(bytes, [&] {
+        UnitColumnFile file{binary.c_str()};
+        const UnitColumnView<Meter> column = file.column<Meter>("depth");
+        double sum = 0;
+        for (const Meter& m : column.span()) {
+            sum += m.value;
+        }
+        loaded = column.size();
+        sink = sum;
+    });
+
+    std::vector<double> parsed(count);
+    const double read_back = time_rate(bytes, [&] {
+        std::FILE* f = std::fopen(text.c_str(), "r");
+        std::string contents(std::filesystem::file_size(text), '\0');
+        contents.resize(std::fread(contents.data(), 1, contents.size(), f));
+        std::fclose(f);
+        char* p = contents.data();
+        double sum = 0;
+        for (double& v : parsed) {
+            v = std::strtod(p, &p);
+            sum += v;
+        }
+        sink = sum;
+    });
+
+    UnitColumnFile file{binary.c_str()};
+    const UnitColumnView<Foot> feet = file.column<Foot>("depth");
+    const double lazy = time_rate(bytes, [&] {
+        double sum = 0;
+        for (std::size_t i = 0; i < feet.size(); i++) {
+            sum += feet[i].value;
+        }
+        sink = sum;
+    });
+
+    std::vector<Foot> converted(count, Foot{0});
+    const double copied = time_rate(bytes, [&] {
+        feet.copy_to(converted);
+        sink = converted.back().value;
+    });
+    std::remove(binary.c_str());
+    std::remove(text.c_str());
+
+    std::printf("%zu values, %.1f MB, %s view of the Meter column in feet\n", count, static_cast<double>(bytes) / 1e6,
+            feet.direct() ? "a direct" : "a converting");
+    std::printf("%-34s %10s\n", "", "GB/s");
+    std::printf("%-34s %10.3f\n", "UnitColumnWriter::write", written);
+    std::printf("%-34s %10.3f\n", "fprintf %.17g", printed);
+    std::printf("%-34s %10.3f\n", "UnitColumnFile + span sum", mapped);
+    std::printf("%-34s %10.3f\n", "fread + strtod", read_back);
+    std::printf("%-34s %10.3f\n", "UnitColumnView<Foot>::operator[]", lazy);
+    std::printf("%-34s %10.3f\n", "UnitColumnView<Foot>::copy_to", copied);
+    const bool same = std::equal(parsed.begin(), parsed.end(), depth.begin(), [](double v, const Meter& m) {
+        return v == m.value;
+    });
+    return saved == UnitColumnError::NONE && loaded == count && same ? 0 : 1;
+}
@@ -0,0 +1,233 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2020 Jack Vandergriff.
+#
+# Measures the compile-time cost of si_units.h by generating translation units with a growing number of unit
+# conversions and growing MultiUnit chain depths, then recording frontend time, template instantiation data, object
+# size, mangled symbol size and debug info size for each one. A second sweep does the same for a growing number of
+# distinct unit_t<"..."> literals. Prints one machine-readable row per generated TU.
+#
+# Usage: bench/compile_bench.py [--cxx g++] [--std 20] [--format csv|json] [--baseline <git-rev>]
+#
+# With clang++ the instantiation count comes from -ftime-trace; with g++ the "template instantiation" phase of
+# -ftime-report is reported instead and the count column is left empty.
+
+import argparse
+import csv
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+HEADERS = ["units.h", "units_17.h", "si_units.h", "dynamic_unit.h", "unit_symbols.h", "unit_parser.h",
+           "unit_literals.h"]
+
+CONVERSION_COUNTS = [0, 16, 64, 256]
+CHAIN_DEPTHS = [1, 4, 8, 16]
+LITERAL_COUNTS = [0, 64, 256, 1024]
+
+# (source type, target type) pairs of equivalent base type from si_units.h
+CONVERSION_PAIRS = [
+    ("Pound", "Newton"),
+    ("PSI", "Pascal"),
+    ("FootPound", "Joule"),
+    ("mph", "mps"),
+    ("Torr", "Atmosphere"),
+    ("Kip", "Newton"),
+    ("Tesla", "MultiUnit<Weber, Per<Square<Meter>>>"),
+    ("Farad", "MultiUnit<Coulomb, Per<Volt>>"),
+]
+
+# factors multiplied together for a chain of the given depth
+CHAIN_FACTORS = ["Newton", "Meter", "Hertz", "Tesla", "Farad", "PSI", "Ohm", "Henry"]
+
+
+def generate_tu(conversions, depth):
+    lines = ['#include "si_units.h"', ""]
+    for i in range(conversions):
+        source, target = CONVERSION_PAIRS[i % len(CONVERSION_PAIRS)]
+        # scaling by a distinct ratio keeps every conversion a separate instantiation
+        lines.append("double convert_{0}(double x) {{ {1} t = UnitRatio<{2}, std::ratio<{3}, 1>>{{x}}; return t.value; }}"
+                     .format(i, target, source, i + 1))
+    terms = " * ".join("{0}{{x}}".format(CHAIN_FACTORS[i % len(CHAIN_FACTORS)]) for i in range(depth))
+    lines.append("double chain(double x) {{ return ({0}).value; }}".format(terms))
+    # the same quantity reached through differently nested expressions, taken by value so the result types end up
+    # in the mangled symbol names
+    for i in range(depth):
+        numerator = " * ".join(CHAIN_FACTORS[j % len(CHAIN_FACTORS)] + "{1}" for j in range(i + 1))
+        lines.append("double sink_{0}(decltype(Joule{{1}} / Foot{{1}} * {1}) r) {{ return r.value; }}".format(i, numerator))
+    lines.append("")
+    return "\n".join(lines)
+
+
+# unit strings for the literal sweep, each repeat made distinct by powers of seconds and amperes
+LITERAL_UNITS = [
+    "kN*m", "lbf/in^2", "mmHg", "kg/(m*s^2)", "ft/s", "km/h", "mph", "W/m^2", "J/kg*K", "m^3/s",
+    "L/min", "kg/m^3", "N*m", "Pa*s", "MPa", "GHz", "mA", "kV", "kg*m^2/s^3", "ft*lbf",
+    "in", "mg/L", "kJ/kg", "W/(m*K)", "1/s", "Ohm", "cd/m^2", "lx", "Gy/h", "t/h",
+]
+
+
+def generate_literal_tu(count):
+    lines = ['#include "unit_literals.h"', ""]
+    for i in range(count):
+        text = LITERAL_UNITS[i % len(LITERAL_UNITS)]
+        power = i // len(LITERAL_UNITS)
+        if power > 0:
+            seconds = (power - 1) % 5 + 1
+            text = "{0}*s^{1}".format(text, seconds if power % 2 else -seconds)
+        if power > 5:
+            text = "{0}*A^{1}".format(text, (power - 1) // 5)
+        # half spelled as types, half as literals
+        if i % 2:
+            lines.append('double literal_{0}(double x) {{ return unit_t<"{1}">{{x}}.value; }}'.format(i, text))
+        else:
+            lines.append('double literal_{0}(double x) {{ return (x * "{1}"_u).value; }}'.format(i, text))
+    lines.append("")
+    return "\n".join(lines)
+
+
+def run(cmd):
+    start = time.perf_counter()
+    proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+    elapsed = time.perf_counter() - start
+    if proc.returncode != 0:
+        sys.stderr.write(proc.stderr)
+        raise SystemExit("compile failed: " + " ".join(cmd))
+    return elapsed, proc.stderr
+
+
+def is_clang(cxx):
+    out = subprocess.run([cxx, "--version"], stdout=subprocess.PIPE, universal_newlines=True).stdout
+    return "clang" in out
+
+
+def parse_gcc_time_report(report):
+    fields = {}
+    for line in report.splitlines():
+        match = re.match(r"\s*(template instantiation|TOTAL)\s*:\s*([\d.]+).*?\s(\d+[kM]?)\s*(?:\(|$)", line)
+        if match:
+            fields[match.group(1)] = (float(match.group(2)), match.group(3))
+    return fields
+
+
+def parse_clang_time_trace(path):
+    with open(path) as f:
+        events = json.load(f)["traceEvents"]
+    count = 0
+    instantiate_us = 0
+    frontend_us = 0
+    for event in events:
+        name = event.get("name", "")
+        if name in ("InstantiateClass", "InstantiateFunction"):
+            count += 1
+        elif name == "Total InstantiateClass" or name == "Total InstantiateFunction":
+            instantiate_us += event.get("dur", 0)
+        elif name == "Total Frontend":
+            frontend_us = event.get("dur", 0)
+    return count, instantiate_us / 1e6, frontend_us / 1e6
+
+
+def text_size(obj):
+    if shutil.which("size") is None:
+        return ""
+    out = subprocess.run(["size", obj], stdout=subprocess.PIPE, universal_newlines=True).stdout.splitlines()
+    return int(out[1].split()[0]) if len(out) > 1 else ""
+
+
+def symbol_bytes(obj):
+    if shutil.which("nm") is None:
+        return ""
+    out = subprocess.run(["nm", "-P", obj], stdout=subprocess.PIPE, universal_newlines=True).stdout.splitlines()
+    return sum(len(line.split()[0]) for line in out if line.strip())
+
+
+def measure(args, include_dir, workdir, conversions, depth, literals):
+    src = os.path.join(workdir, "tu_{0}_{1}_{2}.cpp".format(conversions, depth, literals))
+    obj = src[:-4] + ".o"
+    with open(src, "w") as f:
+        f.write(generate_literal_tu(literals) if literals is not None else generate_tu(conversions, depth))
+
+    base = [args.cxx, "-std=c++" + args.std, "-I" + include_dir]
+    row = {"conversions": conversions, "depth": depth, "literals": literals if literals is not None else ""}
+
+    frontend = min(run(base + ["-fsyntax-only", src])[0] for _ in range(args.repeat))
+    row["frontend_s"] = round(frontend, 4)
+
+    if args.clang:
+        run(base + ["-c", "-O2", "-ftime-trace", src, "-o", obj])
+        count, instantiate, _ = parse_clang_time_trace(obj[:-2] + ".json")
+        row["instantiations"] = count
+        row["instantiation_s"] = round(instantiate, 4)
+        row["frontend_mem"] = ""
+    else:
+        _, report = run(base + ["-fsyntax-only", "-ftime-report", src])
+        fields = parse_gcc_time_report(report)
+        row["instantiations"] = ""
+        row["instantiation_s"] = fields.get("template instantiation", ("", ""))[0]
+        row["frontend_mem"] = fields.get("TOTAL", ("", ""))[1]
+
+    row["compile_s"] = round(run(base + ["-c", "-O2", src, "-o", obj])[0], 4)
+    row["object_bytes"] = os.path.getsize(obj)
+    row["text_bytes"] = text_size(obj)
+    row["symbol_bytes"] = symbol_bytes(obj)
+
+    run(base + ["-c", "-O2", "-g", src, "-o", obj])
+    row["debug_object_bytes"] = os.path.getsize(obj)
+    return row
+
+
+# headers the revision does not have yet are skipped, along with the sweeps that need them
+def export_headers(rev, destination):
+    for header in HEADERS:
+        proc = subprocess.run(["git", "-C", ROOT, "show", "{0}:{1}".format(rev, header)],
+                              stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
+        if proc.returncode != 0:
+            continue
+        with open(os.path.join(destination, header), "wb") as f:
+            f.write(proc.stdout)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compile-time cost benchmark for si_units.h")
+    parser.add_argument("--cxx", default=os.environ.get("CXX", "g++"))
+    parser.add_argument("--std", default="20")
+    parser.add_argument("--format", choices=["csv", "json"], default="csv")
+    parser.add_argument("--repeat", type=int, default=3, help="frontend timing runs per TU, the minimum is reported")
+    parser.add_argument("--baseline", help="also measure the headers as of this git revision")
+    args = parser.parse_args()
+    args.clang = is_clang(args.cxx)
+
+    configurations = [("worktree", ROOT)]
+    with tempfile.TemporaryDirectory() as workdir:
+        if args.baseline:
+            baseline_dir = os.path.join(workdir, "baseline")
+            os.mkdir(baseline_dir)
+            export_headers(args.baseline, baseline_dir)
+            configurations.append((args.baseline, baseline_dir))
+
+        rows = []
+        for name, include_dir in configurations:
+            sweep = [(conversions, depth, None) for conversions in CONVERSION_COUNTS for depth in CHAIN_DEPTHS]
+            if os.path.exists(os.path.join(include_dir, "unit_literals.h")):
+                sweep += [(0, 0, literals) for literals in LITERAL_COUNTS]
+            for conversions, depth, literals in sweep:
+                row = {"headers": name, "compiler": os.path.basename(args.cxx), "std": args.std}
+                row.update(measure(args, include_dir, workdir, conversions, depth, literals))
+                rows.append(row)
+                if args.format == "json":
+                    print(json.dumps(row), flush=True)
+
+    if args.format == "csv":
+        writer = csv.DictWriter(sys.stdout, fieldnames=list(rows[0].keys()))
+        writer.writeheader()
+        writer.writerows(rows)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,126 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+// Throughput of convert_n in GB/s (bytes read + bytes written) next to memcpy over the same buffers, which stands in
+// for the memory bandwidth available at each working set size, and next to a loop of single-unit conversions.
+//     g++ -std=c++20 -O3 -march=native -I.. convert_bench.cpp -o convert_bench && ./convert_bench
+// UNITMAKER_BENCH_REQUIRES_CXX20
+
+#include "si_units.h"
+#include "unit_convert.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+using MillimeterI = SpecifiedUnit<Meter::base_type, std::milli, long>;
+using InchI = SpecifiedUnit<Meter::base_type, std::ratio<254, 10000>, long>;
+using FootF = NumericUnit<Foot, float>;
+using MeterF = NumericUnit<Meter, float>;
+
+inline void clobber_memory() {
+    asm volatile("" : : : "memory");
+}
+
+// best GB/s of several trials, each repeating the kernel over at least 2^30 bytes of traffic
+template<typename Kernel>
+double time_gbps(std::size_t bytes, Kernel kernel) {
+    constexpr std::size_t bytes_per_trial = std::size_t{1} << 30;
+    constexpr int trials = 5;
+    const std::size_t reps = std::max<std::size_t>(2, bytes_per_trial / bytes);
+
+    double best = 0;
+    for (int t = 0; t < trials; t++) {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t r = 0; r < reps; r++) {
+            kernel();
+            clobber_memory();
+        }
+        auto stop = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+        best = std::max(best, static_cast<double>(bytes * reps) / ns);
+    }
+    return best;
+}
+
+struct Result {
+    const char* conversion;
+    std::size_t working_set;
+    double convert_n_gbps;
+    double loop_gbps;
+    double memcpy_gbps;
+};
+
+template<typename From, typename To>
+Result measure(const char* conversion, std::size_t n) {
+    std::vector<From> in(n, From{0});
+    for (std::size_t i = 0; i < n; i++) {
+        in[i] = From{static_cast<decltype(From::value)>(i % 1000)};
+    }
+    std::vector<To> out(n, To{0});
+    const std::size_t bytes = n * (sizeof(From) + sizeof(To));
+
+    Result r{conversion, bytes, 0, 0, 0};
+    // memcpy runs over raw buffers of the same size, units not being trivial types it may copy
+    std::vector<std::byte> raw_in(n * sizeof(To));
+    std::vector<std::byte> raw_out(n * sizeof(To));
+    r.memcpy_gbps = time_gbps(bytes, [&] { std::memcpy(raw_out.data(), raw_in.data(), raw_out.size()); });
+    r.convert_n_gbps = time_gbps(bytes, [&] { convert_n(in, out); });
+    r.loop_gbps = time_gbps(bytes, [&] {
+        for (std::size_t i = 0; i < n; i++) {
+            out[i] = static_cast<To>(in[i]);
+        }
+    });
+    return r;
+}
+
+Result measure_in_place(std::size_t n) {
+    std::vector<Foot> buffer(n, Foot{1});
+    const std::size_t bytes = 2 * n * sizeof(Foot);
+
+    // there is no single-unit equivalent of converting in place, so the loop column stays empty
+    Result r{"Foot->Meter in place", bytes, 0, 0, 0};
+    std::vector<std::byte> raw(n * sizeof(Foot));
+    r.memcpy_gbps = time_gbps(bytes, [&] { std::memmove(raw.data(), raw.data() + sizeof(Foot), raw.size() - sizeof(Foot)); });
+    // converting back and forth keeps the values from drifting off to infinity
+    r.convert_n_gbps = time_gbps(bytes, [&] {
+        auto meters = convert_in_place<Meter>(std::span<Foot>(buffer));
+        convert_in_place<Foot>(meters);
+    }) * 2;
+    return r;
+}
+
+} // namespace
+
+int main() {
+    // per-buffer sizes from L1-resident up to well past any last level cache
+    const std::size_t sizes[] = {
+        std::size_t{1} << 11, std::size_t{1} << 15, std::size_t{1} << 19, std::size_t{1} << 23
+    };
+
+    std::vector<Result> results;
+    for (std::size_t n : sizes) {
+        results.push_back(measure<Pound, Newton>("Pound->Newton double", n));
+        results.push_back(measure<FootF, MeterF>("Foot->Meter float", n));
+        results.push_back(measure<Fahrenheit, Kelvin>("Fahrenheit->Kelvin", n));
+        results.push_back(measure<MillimeterI, InchI>("mm->in long", n));
+        results.push_back(measure_in_place(n));
+    }
+
+    std::printf("%-24s %12s %14s %14s %14s %10s\n", "conversion", "working_set", "convert_n GB/s", "loop GB/s", "memcpy GB/s", "of memcpy");
+    for (const auto& r : results) {
+        char loop[16] = "-";
+        if (r.loop_gbps > 0) {
+            std::snprintf(loop, sizeof(loop), "%.2f", r.loop_gbps);
+        }
+        std::printf("%-24s %10zuKB %14.2f %14s %14.2f %9.0f%%\n", r.conversion, r.working_set / 1024, r.convert_n_gbps,
+                loop, r.memcpy_gbps, 100.0 * r.convert_n_gbps / r.memcpy_gbps);
+    }
+    return 0;
+}
@@ -0,0 +1,136 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+// GB/s of a CSV export with unit-tagged headers read into three converted columns by UnitCsvReader, chunk by chunk and
+// across every hardware thread, next to std::getline and strtod on an std::ifstream with the conversions written out by
+// hand. The resident memory of the process before and after each read shows how little the reader keeps of the file.
+//     g++ -std=c++20 -O3 -march=native -pthread -I.. csv_bench.cpp -o csv_bench && ./csv_bench [rows]
+// UNITMAKER_BENCH_REQUIRES_CXX20
+
+#include "si_units.h"
+#include "unit_csv.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+namespace {
+
+// xorshift, so every run writes the same file
+std::uint64_t next_random(std::uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+void write_csv(const char* path, std::size_t rows) {
+    std::FILE* f = std::fopen(path, "w");
+    std::fputs("time[s],station,pressure[psi],temp[°F],depth[ft]\n", f);
+    std::uint64_t state = 0x9e3779b97f4a7c15;
+    for (std::size_t i = 0; i < rows; i++) {
+        const std::uint64_t r = next_random(state);
+        std::fprintf(f, "%zu,st%02u,%.2f,%.1f,%.3f\n", i, static_cast<unsigned>(r % 64), 14.0 + (r >> 40) % 10000 * 0.01,
+                -20.0 + (r >> 20) % 1200 * 0.1, (r >> 8) % 100000 * 0.001);
+    }
+    std::fclose(f);
+}
+
+// resident set size in MB from /proc, 0 where there is none
+double resident_mb() {
+    std::ifstream status{"/proc/self/status"};
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.starts_with("VmRSS:")) {
+            return std::strtod(line.c_str() + 6, nullptr) / 1024.0;
+        }
+    }
+    return 0.0;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+volatile double sink;
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t rows = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::size_t{1} << 22;
+    const std::string file = (std::filesystem::temp_directory_path() / "unitmaker_csv_bench.csv").string();
+    const char* path = file.c_str();
+    write_csv(path, rows);
+    std::ifstream measure{path, std::ios::binary | std::ios::ate};
+    const double bytes = static_cast<double>(measure.tellg());
+    using Reader = UnitCsvReader<Kilo<Pascal>, Celsius, Meter>;
+    const Reader::chunk_type* last = nullptr;
+
+    // the first read brings the file into the page cache, the ones measured after it read from memory
+    Reader warm{path, {"pressure", "temp", "depth"}};
+    while (warm.next().rows != 0) {
+    }
+
+    const double rss_before = resident_mb();
+    auto start = std::chrono::steady_clock::now();
+    Reader sequential{path, {"pressure", "temp", "depth"}};
+    double sum = 0;
+    std::size_t read = 0;
+    for (;;) {
+        const Reader::chunk_type& c = sequential.next();
+        if (c.rows == 0) {
+            break;
+        }
+        read += c.rows;
+        sum += c.column<0>()[0].value;
+        last = &c;
+    }
+    const double chunked = bytes / seconds_since(start) / 1e9;
+    const double rss_chunked = resident_mb();
+
+    const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    std::atomic<std::size_t> parallel_rows{0};
+    start = std::chrono::steady_clock::now();
+    Reader parallel{path, {"pressure", "temp", "depth"}};
+    parallel.read_parallel([&](const Reader::chunk_type& c) {
+        parallel_rows += c.rows;
+    }, threads);
+    const double threaded = bytes / seconds_since(start) / 1e9;
+
+    start = std::chrono::steady_clock::now();
+    std::ifstream in{path};
+    std::string line;
+    std::getline(in, line);
+    std::size_t naive_rows = 0;
+    while (std::getline(in, line)) {
+        char* p = line.data();
+        std::strtod(p, &p);
+        p = std::strchr(p + 1, ',');
+        const double psi = std::strtod(p + 1, &p);
+        const double fahrenheit = std::strtod(p + 1, &p);
+        const double feet = std::strtod(p + 1, &p);
+        sum += psi * 6.894757293168361 + (fahrenheit - 32.0) * 5.0 / 9.0 + feet * 0.3048;
+        naive_rows++;
+    }
+    const double getline = bytes / seconds_since(start) / 1e9;
+    sink = sum + (last != nullptr ? last->column<2>()[0].value : 0.0);
+    std::remove(path);
+
+    std::printf("%zu rows, %.1f MB, %zu read chunked, %zu in parallel, %zu by getline\n", rows, bytes / 1e6, read,
+            parallel_rows.load(), naive_rows);
+    std::printf("%-34s %10s\n", "", "GB/s");
+    std::printf("%-34s %10.3f\n", "UnitCsvReader::next", chunked);
+    std::printf("UnitCsvReader::read_parallel, %-4u %10.3f\n", threads, threaded);
+    std::printf("%-34s %10.3f\n", "getline + strtod", getline);
+    std::printf("resident memory %.1f MB before the chunked read, %.1f MB after\n", rss_before, rss_chunked);
+    return read == rows && parallel_rows == rows ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+// Units written per second as "value symbol" lines: units_to_chars into one preallocated buffer, snprintf of the value
+// and the symbol, and operator<< into an std::ostringstream, with the heap allocations each made along the way.
+//     g++ -std=c++20 -O3 -march=native -I.. format_bench.cpp -o format_bench && ./format_bench
+// UNITMAKER_BENCH_REQUIRES_CXX20
+
+#include "si_units.h"
+#include "unit_format.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::size_t allocations = 0;
+
+// xorshift, so every run formats the same values
+std::uint64_t next_random(std::uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+struct Rate {
+    double per_second;
+    std::size_t allocations;
+};
+
+// best per-second rate of several calls of kernel, each formatting n units
+template<typename Kernel>
+Rate time_rate(std::size_t n, Kernel kernel) {
+    constexpr int trials = 5;
+    Rate best{0, 0};
+    for (int t = 0; t < trials; t++) {
+        const std::size_t before = allocations;
+        auto start = std::chrono::steady_clock::now();
+        kernel();
+        auto stop = std::chrono::steady_clock::now();
+        best.per_second = std::max(best.per_second, static_cast<double>(n) / std::chrono::duration<double>(stop - start).count());
+        best.allocations = allocations - before;
+    }
+    return best;
+}
+
+volatile std::size_t sink;
+
+// operator new and delete below go through these, kept out of line so that GCC does not take the malloc and free
+// inlined into a new expression and its delete for a mismatched pair
+[[gnu::noinline]] void* allocate(std::size_t size) {
+    allocations++;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void release(void* p) noexcept {
+    std::free(p);
+}
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    return allocate(size);
+}
+
+void operator delete(void* p) noexcept {
+    release(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    release(p);
+}
+
+int main() {
+    using FeetPerSecond2 = MultiUnit<Foot, Hertz, Hertz>;
+    constexpr std::size_t n = std::size_t{1} << 18;
+    std::vector<FeetPerSecond2> units;
+    units.reserve(n);
+    std::uint64_t state = 0x9e3779b97f4a7c15;
+    for (std::size_t i = 0; i < n; i++) {
+        units.emplace_back(static_cast<double>(next_random(state) >> 11) * 0x1.0p-53 * 1000.0 - 500.0);
+    }
+
+    const std::size_t line = unit_chars_max<FeetPerSecond2>() + 1;
+    // one more for the terminator snprintf writes after the last line
+    std::vector<char> buffer(n * line + 1);
+
+    const Rate formatted = time_rate(n, [&] {
+        const std::to_chars_result r = units_to_chars(buffer.data(), buffer.data() + buffer.size(), std::span<const FeetPerSecond2>{units});
+        sink = r.ptr - buffer.data();
+    });
+    const Rate shortest = time_rate(n, [&] {
+        const std::to_chars_result r = units_to_chars(buffer.data(), buffer.data() + buffer.size(), std::span<const FeetPerSecond2>{units},
+                "\n", UnitFormat{std::chars_format::general, -1});
+        sink = r.ptr - buffer.data();
+    });
+    const Rate printed = time_rate(n, [&] {
+        constexpr std::string_view symbol = unit_symbol<FeetPerSecond2>();
+        char* out = buffer.data();
+        for (const FeetPerSecond2& u : units) {
+            out += std::snprintf(out, line + 1, "%g %.*s\n", u.value, static_cast<int>(symbol.size()), symbol.data());
+        }
+        sink = out - buffer.data();
+    });
+    const Rate streamed = time_rate(n, [&] {
+        std::ostringstream os;
+        for (const FeetPerSecond2& u : units) {
+            os << u << '\n';
+        }
+        sink = os.str().size();
+    });
+
+    std::printf("%zu units of %.*s, at most %zu characters each\n", n, static_cast<int>(unit_symbol<FeetPerSecond2>().size()),
+            unit_symbol<FeetPerSecond2>().data(), line - 1);
+    std::printf("%-26s %14s %12s\n", "", "per second", "allocations");
+    std::printf("%-26s %14.3e %12zu\n", "units_to_chars", formatted.per_second, formatted.allocations);
+    std::printf("%-26s %14.3e %12zu\n", "units_to_chars, shortest", shortest.per_second, shortest.allocations);
+    std::printf("%-26s %14.3e %12zu\n", "snprintf", printed.per_second, printed.allocations);
+    std::printf("%-26s %14.3e %12zu\n", "ostringstream", streamed.per_second, streamed.allocations);
+    return 0;
+}
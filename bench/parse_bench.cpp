@@ -0,0 +1,126 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+// Parses per second of unit strings drawn from a corpus shaped like an ingest feed: a few dozen distinct strings, the
+// common ones far more frequent than the rest. Symbol lookup through the perfect hash is measured next to an
+// std::unordered_map over the same symbols, and parsing with and without the interning cache of UnitParser.
+//     g++ -std=c++20 -O3 -march=native -I.. parse_bench.cpp -o parse_bench && ./parse_bench
+// UNITMAKER_BENCH_REQUIRES_CXX20
+
+#include "unit_parser.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const char* const corpus_units[] = {
+    "degC", "kPa", "m/s", "kg", "mm", "Hz", "V", "A", "kW", "psi",
+    "lbf/in^2", "kN*m/s^2", "mmHg", "km/h", "mph", "rpm", "kWh", "W/m^2", "J/kg*K", "m^3/s",
+    "L/min", "kg/m^3", "N*m", "bar", "ft*lbf", "degF", "MPa", "GHz", "mA", "kV",
+    "kg*m^2/s^3", "ft/s^2", "in", "m/s^2", "mg/L", "kJ/kg", "W/(m*K)", "lbf*ft", "1/s", "Ohm",
+    "kg/(m*s^2)", "mV", "cd/m^2", "lx", "Gy/h", "t/h", "MW", "Pa*s", "N/mm^2", "kip/ft",
+};
+
+// xorshift, so every run draws the same corpus
+std::uint64_t next_random(std::uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+// string i drawn with weight 1 / (i + 1), every occurrence in its own allocation like strings off the wire
+std::vector<std::string> make_corpus(std::size_t n) {
+    std::vector<double> cumulative;
+    double total = 0;
+    for (std::size_t i = 0; i < std::size(corpus_units); i++) {
+        total += 1.0 / static_cast<double>(i + 1);
+        cumulative.push_back(total);
+    }
+    std::vector<std::string> corpus;
+    corpus.reserve(n);
+    std::uint64_t state = 0x9e3779b97f4a7c15;
+    for (std::size_t i = 0; i < n; i++) {
+        const double r = static_cast<double>(next_random(state) >> 11) * 0x1.0p-53 * total;
+        const auto it = std::lower_bound(cumulative.begin(), cumulative.end(), r);
+        corpus.emplace_back(corpus_units[std::min<std::size_t>(it - cumulative.begin(), std::size(corpus_units) - 1)]);
+    }
+    return corpus;
+}
+
+// best per-second rate of several passes over items
+template<typename Item, typename Kernel>
+double time_rate(const std::vector<Item>& items, Kernel kernel) {
+    constexpr int trials = 5;
+    double best = 0;
+    for (int t = 0; t < trials; t++) {
+        auto start = std::chrono::steady_clock::now();
+        for (const Item& item : items) {
+            kernel(item);
+        }
+        auto stop = std::chrono::steady_clock::now();
+        best = std::max(best, static_cast<double>(items.size()) / std::chrono::duration<double>(stop - start).count());
+    }
+    return best;
+}
+
+volatile std::uint64_t sink;
+
+} // namespace
+
+int main() {
+    constexpr std::size_t n = std::size_t{1} << 20;
+    const std::vector<std::string> corpus = make_corpus(n);
+
+    std::vector<std::string> symbols;
+    for (std::size_t i = 0; i < n; i++) {
+        symbols.emplace_back(unit_symbols[i % unit_symbols.size()].name());
+    }
+    std::unordered_map<std::string_view, const UnitSymbol*> symbol_map;
+    for (const UnitSymbol& symbol : unit_symbols) {
+        symbol_map.emplace(symbol.name(), &symbol);
+    }
+
+    std::uint64_t check = 0;
+    const double perfect = time_rate(symbols, [&](const std::string& s) {
+        check += find_unit_symbol(s)->dimension;
+    });
+    const double map = time_rate(symbols, [&](const std::string& s) {
+        check += symbol_map.find(s)->second->dimension;
+    });
+
+    std::size_t failed = 0;
+    const double uncached = time_rate(corpus, [&](const std::string& s) {
+        const UnitParseResult r = parse_unit(s);
+        failed += !r;
+        check += r.unit.dimension;
+    });
+
+    std::vector<std::byte> memory(std::size_t{1} << 16);
+    UnitArena arena{memory};
+    UnitParser<> parser{arena};
+    const double cached = time_rate(corpus, [&](const std::string& s) {
+        const UnitParseResult r = parser.parse(s);
+        check += r.unit.dimension;
+    });
+    sink = check;
+
+    std::printf("%zu symbols, corpus of %zu strings (%zu distinct, %zu unknown to the parser per pass)\n",
+            unit_symbols.size(), n, parser.size(), failed / 5);
+    std::printf("%-28s %14s\n", "", "per second");
+    std::printf("%-28s %14.3e\n", "symbol lookup, perfect hash", perfect);
+    std::printf("%-28s %14.3e\n", "symbol lookup, unordered_map", map);
+    std::printf("%-28s %14.3e\n", "parse_unit", uncached);
+    std::printf("%-28s %14.3e\n", "UnitParser, interned", cached);
+    std::printf("arena holds %zu bytes for the interned strings\n", arena.size());
+    return 0;
+}
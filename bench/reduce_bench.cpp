@@ -0,0 +1,141 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+// GB/s of unit_reduce over Joule readings and unit_dot of Watt and Second, on ThreadPools of 1 thread up to every
+// hardware thread, next to std::accumulate and a plain loop. The relative error of each sum against a compensated
+// long double reference shows what pairwise summation buys; the pairwise sums are the same bits at every thread count.
+//     g++ -std=c++20 -O3 -march=native -pthread -I.. reduce_bench.cpp -o reduce_bench && ./reduce_bench [elements]
+// UNITMAKER_BENCH_REQUIRES_CXX20
+
+#include "si_units.h"
+#include "unit_reduce.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// xorshift, so every run sums the same readings
+std::uint64_t next_random(std::uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+// best GB/s of several calls of kernel over bytes of input
+template<typename Kernel>
+double time_rate(std::size_t bytes, Kernel kernel) {
+    constexpr int trials = 5;
+    double best = 0;
+    for (int t = 0; t < trials; t++) {
+        auto start = std::chrono::steady_clock::now();
+        kernel();
+        auto stop = std::chrono::steady_clock::now();
+        best = std::max(best, static_cast<double>(bytes) / std::chrono::duration<double>(stop - start).count() / 1e9);
+    }
+    return best;
+}
+
+// Neumaier's compensated sum in long double, the reference the others are measured against
+template<typename Load>
+long double reference_sum(std::size_t n, Load load) {
+    long double sum = 0;
+    long double compensation = 0;
+    for (std::size_t i = 0; i < n; i++) {
+        const long double x = load(i);
+        const long double t = sum + x;
+        compensation += std::fabs(sum) >= std::fabs(x) ? (sum - t) + x : (x - t) + sum;
+        sum = t;
+    }
+    return sum + compensation;
+}
+
+double relative_error(double sum, long double reference) {
+    return static_cast<double>(std::fabs((static_cast<long double>(sum) - reference) / reference));
+}
+
+volatile double sink;
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::size_t{1} << 24;
+    std::vector<Joule> energy(n, Joule{0});
+    std::vector<Watt> power(n, Watt{0});
+    std::vector<Second> durations(n, Second{0});
+    std::uint64_t state = 0x9e3779b97f4a7c15;
+    for (std::size_t i = 0; i < n; i++) {
+        // a large baseline with small readings on top, where a running sum loses the most
+        energy[i] = Joule{1e6 + static_cast<double>(next_random(state) >> 11) * 0x1.0p-53};
+        power[i] = Watt{1500.0 + static_cast<double>(next_random(state) % 1000) / 7.0};
+        durations[i] = Second{0.1 + static_cast<double>(next_random(state) % 100) * 1e-4};
+    }
+    const long double energy_reference = reference_sum(n, [&](std::size_t i) {
+        return static_cast<long double>(energy[i].value);
+    });
+    const long double dot_reference = reference_sum(n, [&](std::size_t i) {
+        return static_cast<long double>(power[i].value) * durations[i].value;
+    });
+
+    std::printf("%zu elements\n", n);
+    std::printf("%-28s %12s %12s %12s %12s\n", "", "reduce GB/s", "rel. error", "dot GB/s", "rel. error");
+    double loop_sum = 0;
+    const double loop = time_rate(n * sizeof(Joule), [&] {
+        loop_sum = 0;
+        for (const Joule& e : energy) {
+            loop_sum += e.value;
+        }
+        sink = loop_sum;
+    });
+    double loop_dot = 0;
+    const double loop_dot_rate = time_rate(n * 2 * sizeof(double), [&] {
+        loop_dot = 0;
+        for (std::size_t i = 0; i < n; i++) {
+            loop_dot += power[i].value * durations[i].value;
+        }
+        sink = loop_dot;
+    });
+    std::printf("%-28s %12.3f %12.2e %12.3f %12.2e\n", "plain loop", loop, relative_error(loop_sum, energy_reference),
+            loop_dot_rate, relative_error(loop_dot, dot_reference));
+    double accumulated = 0;
+    const double accumulate = time_rate(n * sizeof(Joule), [&] {
+        accumulated = std::accumulate(energy.begin(), energy.end(), Joule{0}).value;
+        sink = accumulated;
+    });
+    std::printf("%-28s %12.3f %12.2e\n", "std::accumulate", accumulate, relative_error(accumulated, energy_reference));
+
+    const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    Joule first_sum{0};
+    bool same = true;
+    for (unsigned threads = 1;; threads = std::min(threads * 2, hardware)) {
+        ThreadPool pool{threads};
+        Joule sum{0};
+        const double reduced = time_rate(n * sizeof(Joule), [&] {
+            sum = unit_reduce(pool, energy);
+            sink = sum.value;
+        });
+        Joule dot{0};
+        const double dotted = time_rate(n * 2 * sizeof(double), [&] {
+            dot = unit_dot(pool, power, durations);
+            sink = dot.value;
+        });
+        first_sum = threads == 1 ? sum : first_sum;
+        same = same && sum.value == first_sum.value;
+        std::printf("unit_reduce/unit_dot, %-6u %12.3f %12.2e %12.3f %12.2e\n", threads, reduced,
+                relative_error(sum.value, energy_reference), dotted, relative_error(dot.value, dot_reference));
+        if (threads == hardware) {
+            break;
+        }
+    }
+    return same ? 0 : 1;
+}
@@ -0,0 +1,225 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+// Millions of Volt samples per second passed from a producer thread to a consumer thread through a UnitRing one at a
+// time, in spans of 256 copied in and out, and written and read in place with the consumer running convert_n to
+// Milli<Volt> on the ring's memory; then timestamped Second and Volt rows in spans. The latency is half the round trip
+// of one sample sent to another thread and sent straight back through a second ring. A thread that finds its ring full
+// or empty yields, so the bench also runs on fewer cores than threads.
+//     g++ -std=c++20 -O3 -march=native -pthread -I.. ring_bench.cpp -o ring_bench && ./ring_bench [samples] [capacity]
+// UNITMAKER_BENCH_REQUIRES_CXX20
+
+#include "si_units.h"
+#include "unit_convert.h"
+#include "unit_ring.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t batch = 256;
+
+// best millions of samples per second of several runs of produce() on a thread of its own and consume() on this one
+template<typename Produce, typename Consume>
+double time_rate(std::size_t samples, Produce produce, Consume consume) {
+    constexpr int trials = 5;
+    double best = 0;
+    for (int t = 0; t < trials; t++) {
+        auto start = std::chrono::steady_clock::now();
+        std::thread producer{produce};
+        consume();
+        producer.join();
+        auto stop = std::chrono::steady_clock::now();
+        best = std::max(best, static_cast<double>(samples) / std::chrono::duration<double>(stop - start).count() / 1e6);
+    }
+    return best;
+}
+
+double sample(std::size_t i) {
+    return static_cast<double>(i & 1023) * 0.01;
+}
+
+volatile double sink;
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::size_t{1} << 24;
+    const std::size_t capacity = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4096;
+    std::printf("%zu samples, capacity %zu\n", n, capacity);
+    std::printf("%-34s %12s\n", "", "M samples/s");
+    bool exact = true;
+
+    UnitRing<Volt> ring{capacity};
+    const double single = time_rate(n, [&] {
+        for (std::size_t i = 0; i < n;) {
+            if (ring.push(Volt{sample(i)})) {
+                i++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }, [&] {
+        double sum = 0;
+        Volt v{0};
+        for (std::size_t i = 0; i < n;) {
+            if (ring.pop(v)) {
+                sum += v.value;
+                i++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        sink = sum;
+    });
+    std::printf("%-34s %12.1f\n", "push/pop one", single);
+
+    const double spans = time_rate(n, [&] {
+        std::vector<Volt> out(batch, Volt{0});
+        for (std::size_t i = 0; i < n;) {
+            const std::size_t rows = std::min(batch, n - i);
+            for (std::size_t j = 0; j < rows; j++) {
+                out[j] = Volt{sample(i + j)};
+            }
+            for (std::size_t pushed = 0; pushed < rows;) {
+                const std::size_t count = ring.push(std::span<const Volt>{out.data() + pushed, rows - pushed});
+                pushed += count;
+                if (count == 0) {
+                    std::this_thread::yield();
+                }
+            }
+            i += rows;
+        }
+    }, [&] {
+        std::vector<Volt> in(batch, Volt{0});
+        double sum = 0;
+        for (std::size_t i = 0; i < n;) {
+            const std::size_t count = ring.pop(std::span<Volt>{in});
+            for (std::size_t j = 0; j < count; j++) {
+                sum += in[j].value;
+            }
+            i += count;
+            if (count == 0) {
+                std::this_thread::yield();
+            }
+        }
+        sink = sum;
+    });
+    std::printf("%-34s %12.1f\n", "push/pop spans of 256", spans);
+
+    const double in_place = time_rate(n, [&] {
+        for (std::size_t i = 0; i < n;) {
+            const auto free = ring.writable();
+            const std::span<Volt> out = free.column();
+            const std::size_t rows = std::min(out.size(), n - i);
+            for (std::size_t j = 0; j < rows; j++) {
+                out[j] = Volt{sample(i + j)};
+            }
+            ring.publish(rows);
+            i += rows;
+            if (rows == 0) {
+                std::this_thread::yield();
+            }
+        }
+    }, [&] {
+        std::vector<Milli<Volt>> millivolts(ring.capacity(), Milli<Volt>{0});
+        double sum = 0;
+        for (std::size_t i = 0; i < n;) {
+            const auto ready = ring.readable();
+            convert_n(ready.column(), std::span<Milli<Volt>>{millivolts});
+            for (std::size_t j = 0; j < ready.rows; j++) {
+                sum += millivolts[j].value;
+            }
+            ring.consume(ready.rows);
+            i += ready.rows;
+            if (ready.rows == 0) {
+                std::this_thread::yield();
+            }
+        }
+        sink = sum;
+    });
+    std::printf("%-34s %12.1f\n", "in place, convert_n to mV", in_place);
+
+    UnitRing<Second, Volt> timed{capacity};
+    const double timed_spans = time_rate(n, [&] {
+        std::vector<Second> times(batch, Second{0});
+        std::vector<Volt> values(batch, Volt{0});
+        for (std::size_t i = 0; i < n;) {
+            const std::size_t rows = std::min(batch, n - i);
+            for (std::size_t j = 0; j < rows; j++) {
+                times[j] = Second{static_cast<double>(i + j) * 1e-4};
+                values[j] = Volt{sample(i + j)};
+            }
+            for (std::size_t pushed = 0; pushed < rows;) {
+                const std::size_t count = timed.push(std::span<const Second>{times.data() + pushed, rows - pushed},
+                        std::span<const Volt>{values.data() + pushed, rows - pushed});
+                pushed += count;
+                if (count == 0) {
+                    std::this_thread::yield();
+                }
+            }
+            i += rows;
+        }
+    }, [&] {
+        std::vector<Second> times(batch, Second{0});
+        std::vector<Volt> values(batch, Volt{0});
+        double last = -1;
+        for (std::size_t i = 0; i < n;) {
+            const std::size_t count = timed.pop(std::span<Second>{times}, std::span<Volt>{values});
+            for (std::size_t j = 0; j < count; j++) {
+                exact = exact && times[j].value > last && values[j].value == sample(i + j);
+                last = times[j].value;
+            }
+            i += count;
+            if (count == 0) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    std::printf("%-34s %12.1f\n", "Second and Volt rows, spans", timed_spans);
+
+    // one sample at a time to the other thread and back
+    constexpr std::size_t round_trips = 100000;
+    UnitRing<Second> there{capacity};
+    UnitRing<Second> back{capacity};
+    std::vector<double> latencies;
+    latencies.reserve(round_trips);
+    std::thread echo{[&] {
+        Second t{0};
+        for (std::size_t i = 0; i < round_trips; i++) {
+            while (!there.pop(t)) {
+                std::this_thread::yield();
+            }
+            while (!back.push(t)) {
+                std::this_thread::yield();
+            }
+        }
+    }};
+    for (std::size_t i = 0; i < round_trips; i++) {
+        const auto start = std::chrono::steady_clock::now();
+        while (!there.push(Second{static_cast<double>(i)})) {
+            std::this_thread::yield();
+        }
+        Second t{0};
+        while (!back.pop(t)) {
+            std::this_thread::yield();
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        exact = exact && t.value == static_cast<double>(i);
+        latencies.push_back(std::chrono::duration<double, std::nano>(stop - start).count() / 2);
+    }
+    echo.join();
+    std::sort(latencies.begin(), latencies.end());
+    std::printf("%-34s %12.0f %12.0f\n", "one-way latency ns, median, p99", latencies[round_trips / 2],
+            latencies[round_trips * 99 / 100]);
+    return exact ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+// Checks that a UnitRing<Second, Volt> hands every row from a producer thread to a consumer thread once, in order and
+// with its columns together, while both threads switch between the single-row, span and in-place calls, the consumer
+// running convert_n to Milli<Volt> on the ring's memory. Meant to be run under ThreadSanitizer, which also sees the
+// convert_n kernels since unit_kernels.h leaves out the SIMD dispatch in such builds; exits with 1 on a wrong row.
+//     g++ -std=c++20 -O1 -g -fsanitize=thread -pthread -I.. ring_check.cpp -o ring_check && ./ring_check [rows] [capacity]
+// UNITMAKER_BENCH_REQUIRES_CXX20
+
+#include "si_units.h"
+#include "unit_convert.h"
+#include "unit_ring.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstddef>
+#include <cstdlib>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// an odd span length, so that spans keep landing across the end of the ring's arrays
+constexpr std::size_t batch = 37;
+
+Second time_of(std::size_t row) {
+    return Second{static_cast<double>(row)};
+}
+
+Volt volts_of(std::size_t row) {
+    return Volt{static_cast<double>(row) * 0.5};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    const std::size_t capacity = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000;
+    UnitRing<Second, Volt> ring{capacity};
+
+    std::thread producer{[&] {
+        std::vector<Second> times(batch, Second{0});
+        std::vector<Volt> values(batch, Volt{0});
+        for (std::size_t i = 0, call = 0; i < n; call++) {
+            std::size_t rows = 0;
+            if (call % 3 == 0) {
+                rows = ring.push(time_of(i), volts_of(i)) ? 1 : 0;
+            } else if (call % 3 == 1) {
+                const std::size_t count = std::min(batch, n - i);
+                for (std::size_t j = 0; j < count; j++) {
+                    times[j] = time_of(i + j);
+                    values[j] = volts_of(i + j);
+                }
+                rows = ring.push(std::span<const Second>{times.data(), count}, std::span<const Volt>{values.data(), count});
+            } else {
+                const auto free = ring.writable();
+                rows = std::min(free.rows, n - i);
+                for (std::size_t j = 0; j < rows; j++) {
+                    free.column<0>()[j] = time_of(i + j);
+                    free.column<1>()[j] = volts_of(i + j);
+                }
+                ring.publish(rows);
+            }
+            i += rows;
+            if (rows == 0) {
+                std::this_thread::yield();
+            }
+        }
+    }};
+
+    bool exact = true;
+    std::vector<Second> times(batch, Second{0});
+    std::vector<Volt> values(batch, Volt{0});
+    std::vector<Milli<Volt>> millivolts(ring.capacity(), Milli<Volt>{0});
+    for (std::size_t i = 0, call = 0; i < n; call++) {
+        std::size_t rows = 0;
+        if (call % 3 == 0) {
+            Second t{0};
+            Volt v{0};
+            if (ring.pop(t, v)) {
+                rows = 1;
+                exact = exact && t.value == time_of(i).value && v.value == volts_of(i).value;
+            }
+        } else if (call % 3 == 1) {
+            rows = ring.pop(std::span<Second>{times}, std::span<Volt>{values});
+            for (std::size_t j = 0; j < rows; j++) {
+                exact = exact && times[j].value == time_of(i + j).value && values[j].value == volts_of(i + j).value;
+            }
+        } else {
+            const auto ready = ring.readable();
+            rows = ready.rows;
+            convert_n(ready.column<1>(), std::span<Milli<Volt>>{millivolts.data(), rows});
+            for (std::size_t j = 0; j < rows; j++) {
+                const Milli<Volt> expected = volts_of(i + j);
+                exact = exact && ready.column<0>()[j].value == time_of(i + j).value
+                        && millivolts[j].value == expected.value;
+            }
+            ring.consume(rows);
+        }
+        i += rows;
+        if (rows == 0) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    exact = exact && ring.size() == 0;
+
+    std::printf("%zu rows through a ring of %zu: %s\n", n, ring.capacity(), exact ? "in order" : "WRONG");
+    return exact ? 0 : 1;
+}
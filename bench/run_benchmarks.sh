@@ -0,0 +1,35 @@
+#!/bin/sh
+#
+# Copyright (c) 2020 Jack Vandergriff.
+#
+# Builds every bench/*_bench.cpp against units.h (C++20) and units_17.h (C++17) and runs it.
+# Usage: bench/run_benchmarks.sh [bench-name ...]     e.g. bench/run_benchmarks.sh runtime
+# Environment: CXX (default g++), CXXFLAGS (default -O3 -march=native), STANDARDS (default "20 17")
+
+set -e
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+OUT=${BENCH_BUILD_DIR:-"$ROOT/_bench_build"}
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:-"-O3 -march=native"}
+STANDARDS=${STANDARDS:-"20 17"}
+
+mkdir -p "$OUT"
+
+if [ $# -eq 0 ]; then
+    set -- $(cd "$ROOT/bench" && ls *_bench.cpp | sed 's/_bench\.cpp$//')
+fi
+
+for name in "$@"; do
+    src="$ROOT/bench/${name}_bench.cpp"
+    for std in $STANDARDS; do
+        # benches written against C++20-only headers opt out of the C++17 run
+        if [ "$std" -lt 20 ] && grep -q 'UNITMAKER_BENCH_REQUIRES_CXX20' "$src"; then
+            continue
+        fi
+        bin="$OUT/${name}_bench_cxx$std"
+        $CXX -std=c++$std $CXXFLAGS -pthread -I"$ROOT" "$src" -o "$bin"
+        "$bin"
+        echo
+    done
+done
@@ -0,0 +1,184 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+// Times every operator of units.h (or units_17.h, depending on -std) against the equivalent hand-written double code.
+// Build and run for both headers with bench/run_benchmarks.sh, or by hand:
+//     g++ -std=c++20 -O3 -march=native -I.. runtime_bench.cpp -o runtime_bench && ./runtime_bench
+
+#include "si_units.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <vector>
+
+namespace {
+
+template<typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void clobber_memory() {
+    asm volatile("" : : : "memory");
+}
+
+// Runs kernel(i) over [0, n) enough times to get a stable figure, returns the best ns/element of several trials
+template<typename Kernel>
+double time_kernel(std::size_t n, Kernel kernel) {
+    constexpr std::size_t elements_per_trial = std::size_t{1} << 26;
+    constexpr int trials = 5;
+    const std::size_t reps = std::max<std::size_t>(2, elements_per_trial / n);
+
+    double best = 1e300;
+    for (int t = 0; t < trials; t++) {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t r = 0; r < reps; r++) {
+            for (std::size_t i = 0; i < n; i++) {
+                kernel(i);
+            }
+            clobber_memory();
+        }
+        auto stop = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+        best = std::min(best, ns / static_cast<double>(reps * n));
+    }
+    return best;
+}
+
+struct Result {
+    const char* op;
+    std::size_t bytes;
+    double unit_ns;
+    double double_ns;
+};
+
+template<typename UnitKernel, typename DoubleKernel>
+Result compare(const char* op, std::size_t n, std::size_t bytes, UnitKernel unit_kernel, DoubleKernel double_kernel) {
+    // interleave runs so frequency scaling and cache warmth affect both sides equally
+    double double_ns = time_kernel(n, double_kernel);
+    double unit_ns = time_kernel(n, unit_kernel);
+    double_ns = std::min(double_ns, time_kernel(n, double_kernel));
+    unit_ns = std::min(unit_ns, time_kernel(n, unit_kernel));
+    return {op, bytes, unit_ns, double_ns};
+}
+
+template<typename T>
+std::vector<T> fill(std::size_t n, double start) {
+    std::vector<T> v(n, T{0});
+    for (std::size_t i = 0; i < n; i++) {
+        v[i] = T{start + static_cast<double>(i % 1024) * 0.25};
+    }
+    return v;
+}
+
+std::vector<double> fill_double(std::size_t n, double start) {
+    std::vector<double> v(n);
+    for (std::size_t i = 0; i < n; i++) {
+        v[i] = start + static_cast<double>(i % 1024) * 0.25;
+    }
+    return v;
+}
+
+void run_size(std::size_t n, std::vector<Result>& results) {
+    // working set is two inputs and one output
+    const std::size_t bytes = 3 * n * sizeof(double);
+    const double scalar = 2.5;
+    const double foot_to_meter = 0.3048;
+
+    auto meters = fill<Meter>(n, 1.0);
+    auto feet = fill<Foot>(n, 2.0);
+    auto seconds = fill<Second>(n, 3.0);
+    auto a = fill_double(n, 1.0);
+    auto b = fill_double(n, 2.0);
+    auto c = fill_double(n, 3.0);
+    std::vector<double> out(n);
+
+    {
+        std::vector<Meter> converted(n, Meter{0});
+        results.push_back(compare("operator To (Foot->Meter)", n, bytes,
+            [&](std::size_t i) { converted[i] = feet[i]; },
+            [&](std::size_t i) { out[i] = b[i] * foot_to_meter; }));
+        do_not_optimize(converted.data());
+    }
+    {
+        std::vector<decltype(meters[0] * seconds[0])> product(n, decltype(meters[0] * seconds[0]){0});
+        results.push_back(compare("unit * unit", n, bytes,
+            [&](std::size_t i) { product[i] = meters[i] * seconds[i]; },
+            [&](std::size_t i) { out[i] = a[i] * c[i]; }));
+        do_not_optimize(product.data());
+    }
+    {
+        std::vector<decltype(meters[0] / seconds[0])> quotient(n, decltype(meters[0] / seconds[0]){0});
+        results.push_back(compare("unit / unit", n, bytes,
+            [&](std::size_t i) { quotient[i] = meters[i] / seconds[i]; },
+            [&](std::size_t i) { out[i] = a[i] / c[i]; }));
+        do_not_optimize(quotient.data());
+    }
+    {
+        std::vector<decltype(scalar * meters[0])> scaled(n, decltype(scalar * meters[0]){0});
+        results.push_back(compare("scalar * unit", n, bytes,
+            [&](std::size_t i) { scaled[i] = scalar * meters[i]; },
+            [&](std::size_t i) { out[i] = scalar * a[i]; }));
+        do_not_optimize(scaled.data());
+    }
+    {
+        std::vector<decltype(meters[0] * scalar)> scaled(n, decltype(meters[0] * scalar){0});
+        results.push_back(compare("unit * scalar", n, bytes,
+            [&](std::size_t i) { scaled[i] = meters[i] * scalar; },
+            [&](std::size_t i) { out[i] = a[i] * scalar; }));
+        do_not_optimize(scaled.data());
+    }
+    {
+        std::vector<decltype(scalar / meters[0])> inverted(n, decltype(scalar / meters[0]){0});
+        results.push_back(compare("scalar / unit", n, bytes,
+            [&](std::size_t i) { inverted[i] = scalar / meters[i]; },
+            [&](std::size_t i) { out[i] = scalar / a[i]; }));
+        do_not_optimize(inverted.data());
+    }
+    {
+        std::vector<decltype(meters[0] / scalar)> scaled(n, decltype(meters[0] / scalar){0});
+        results.push_back(compare("unit / scalar", n, bytes,
+            [&](std::size_t i) { scaled[i] = meters[i] / scalar; },
+            [&](std::size_t i) { out[i] = a[i] / scalar; }));
+        do_not_optimize(scaled.data());
+    }
+    {
+        std::vector<decltype(meters[0] + feet[0])> sum(n, decltype(meters[0] + feet[0]){0});
+        results.push_back(compare("Meter + Foot", n, bytes,
+            [&](std::size_t i) { sum[i] = meters[i] + feet[i]; },
+            [&](std::size_t i) { out[i] = a[i] + b[i] * foot_to_meter; }));
+        do_not_optimize(sum.data());
+    }
+    {
+        std::vector<decltype(meters[0] - feet[0])> difference(n, decltype(meters[0] - feet[0]){0});
+        results.push_back(compare("Meter - Foot", n, bytes,
+            [&](std::size_t i) { difference[i] = meters[i] - feet[i]; },
+            [&](std::size_t i) { out[i] = a[i] - b[i] * foot_to_meter; }));
+        do_not_optimize(difference.data());
+    }
+    do_not_optimize(out.data());
+}
+
+} // namespace
+
+int main() {
+    // working sets from L1-resident up to well past any last level cache
+    const std::size_t sizes[] = {
+        std::size_t{1} << 10, std::size_t{1} << 13, std::size_t{1} << 16, std::size_t{1} << 19, std::size_t{1} << 23
+    };
+
+    std::vector<Result> results;
+    for (std::size_t n : sizes) {
+        run_size(n, results);
+    }
+
+    std::printf("# %s, C++%ld\n", __cplusplus > 201703L ? "units.h" : "units_17.h", __cplusplus / 100 % 100);
+    std::printf("%-28s %12s %14s %14s %10s\n", "operator", "working_set", "unit_ns/elem", "double_ns/elem", "overhead");
+    for (const auto& r : results) {
+        std::printf("%-28s %10zuKB %14.3f %14.3f %9.3fx\n", r.op, r.bytes / 1024, r.unit_ns, r.double_ns, r.unit_ns / r.double_ns);
+    }
+    return 0;
+}
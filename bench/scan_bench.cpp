@@ -0,0 +1,114 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+// GB/s of "number unit" log lines read into Meter values by scan_units, next to a line-at-a-time loop of memchr,
+// strtod and parse_unit, and next to finding the line breaks alone, the most any scanner of the text could manage.
+//     g++ -std=c++20 -O3 -march=native -I.. scan_bench.cpp -o scan_bench && ./scan_bench
+// UNITMAKER_BENCH_REQUIRES_CXX20
+
+#include "si_units.h"
+#include "unit_scan.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+// mostly metres and feet, a few other lengths, and every 1000th line a pressure that does not convert
+const char* const log_units[] = {"m", "m", "m", "ft", "ft", "mm", "in", "km", "yd", "mi"};
+
+// xorshift, so every run reads the same log
+std::uint64_t next_random(std::uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+std::string make_log(std::size_t lines) {
+    std::string log;
+    std::uint64_t state = 0x9e3779b97f4a7c15;
+    char line[64];
+    for (std::size_t i = 0; i < lines; i++) {
+        const std::uint64_t r = next_random(state);
+        const double value = static_cast<double>(r >> 11) * 0x1.0p-53 * 1000.0;
+        const char* unit = i % 1000 == 999 ? "psi" : log_units[r % std::size(log_units)];
+        // sensors print a fixed number of decimals, a few use exponents
+        const int n = r % 16 == 0 ? std::snprintf(line, sizeof(line), "%.3e %s\n", value, unit)
+                : std::snprintf(line, sizeof(line), "%.*f %s\n", static_cast<int>(r >> 60) % 4, value, unit);
+        log.append(line, n);
+    }
+    return log;
+}
+
+// best GB/s of several calls of kernel over bytes of text
+template<typename Kernel>
+double time_rate(std::size_t bytes, Kernel kernel) {
+    constexpr int trials = 5;
+    double best = 0;
+    for (int t = 0; t < trials; t++) {
+        auto start = std::chrono::steady_clock::now();
+        kernel();
+        auto stop = std::chrono::steady_clock::now();
+        best = std::max(best, static_cast<double>(bytes) / std::chrono::duration<double>(stop - start).count() / 1e9);
+    }
+    return best;
+}
+
+volatile double sink;
+
+} // namespace
+
+int main() {
+    constexpr std::size_t lines = std::size_t{1} << 22;
+    const std::string log = make_log(lines);
+    std::vector<Meter> out(lines, Meter{0});
+    std::vector<UnitScanIssue> issues(lines / 100);
+
+    std::vector<std::uint64_t> masks(log.size() / 64);
+    const double breaks = time_rate(log.size(), [&] {
+        line_break_masks(log.data(), masks.size(), masks.data());
+        sink = static_cast<double>(masks.back());
+    });
+
+    UnitScanResult result;
+    const double scanned = time_rate(log.size(), [&] {
+        result = scan_units(log, std::span<Meter>{out}, std::span<UnitScanIssue>{issues});
+        sink = out[result.values - 1].value;
+    });
+
+    std::size_t naive_values = 0;
+    const double naive = time_rate(log.size(), [&] {
+        naive_values = 0;
+        const char* p = log.data();
+        const char* const end = p + log.size();
+        while (p < end) {
+            const char* line_end = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            char* number_end;
+            const double v = std::strtod(p, &number_end);
+            const UnitParseResult unit = parse_unit({number_end + 1, static_cast<std::size_t>(line_end - number_end - 1)});
+            if (unit && unit.unit.dimension == Meter::base_type::packed) {
+                out[naive_values++] = Meter{unit.unit(v).value};
+            }
+            p = line_end + 1;
+        }
+        sink = out[naive_values - 1].value;
+    });
+
+    std::printf("%zu lines, %.1f MB, %zu values and %zu issues\n", lines, static_cast<double>(log.size()) / 1e6,
+            result.values, result.issues);
+    std::printf("%-34s %10s %14s\n", "", "GB/s", "lines/s");
+    const double bytes_per_line = static_cast<double>(log.size()) / lines;
+    std::printf("%-34s %10.3f %14.3e\n", "line breaks only", breaks, breaks * 1e9 / bytes_per_line);
+    std::printf("%-34s %10.3f %14.3e\n", "scan_units", scanned, scanned * 1e9 / bytes_per_line);
+    std::printf("%-34s %10.3f %14.3e\n", "memchr + strtod + parse_unit", naive, naive * 1e9 / bytes_per_line);
+    return naive_values == result.values ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+// Samples per second appended to a UnitSeries<Watt> of one reading a second, then the time and bytes of a dashboard
+// query: hourly min, max and mean in kilowatts over the last 30 days, once from the rollup levels and once by scanning
+// the samples, next to the same aggregation over a std::vector in memory.
+//     g++ -std=c++20 -O3 -march=native -I.. series_bench.cpp -o series_bench && ./series_bench [samples]
+// UNITMAKER_BENCH_REQUIRES_CXX20
+
+#include "si_units.h"
+#include "unit_series.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <vector>
+
+namespace {
+
+// xorshift, so every run stores the same readings
+std::uint64_t next_random(std::uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// best seconds of several calls of kernel
+template<typename Kernel>
+double best_time(Kernel kernel) {
+    constexpr int trials = 5;
+    double best = 1e300;
+    for (int t = 0; t < trials; t++) {
+        auto start = std::chrono::steady_clock::now();
+        kernel();
+        best = std::min(best, seconds_since(start));
+    }
+    return best;
+}
+
+volatile double sink;
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t samples = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::size_t{1} << 22;
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "unitmaker_series_bench";
+    std::filesystem::remove_all(directory);
+    constexpr double start_time = 1600000000;
+
+    std::vector<Watt> readings(samples, Watt{0});
+    std::uint64_t state = 0x9e3779b97f4a7c15;
+    for (std::size_t i = 0; i < samples; i++) {
+        // a daily load curve and noise
+        const double day = std::sin(2 * 3.141592653589793 * static_cast<double>(i) / 86400.0);
+        readings[i] = Watt{1500.0 + 800.0 * day + static_cast<double>(next_random(state) % 1000) / 10.0};
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    UnitSeries<Watt> series{directory};
+    for (std::size_t i = 0; i < samples; i++) {
+        series.append(Second{start_time + static_cast<double>(i)}, readings[i]);
+    }
+    const double appended = static_cast<double>(samples) / seconds_since(start);
+
+    const Second to{start_time + static_cast<double>(samples)};
+    const Second from{std::max(start_time, to.value - 30 * 86400.0)};
+    const Second hour{3600};
+    std::vector<UnitRollup<Kilo<Watt>>> dashboard;
+    const double rolled = best_time([&] {
+        dashboard = series.rollup<Kilo<Watt>>(from, to, hour);
+        sink = dashboard.back().mean.value;
+    });
+
+    std::size_t scanned_samples = 0;
+    const double scanned = best_time([&] {
+        std::vector<UnitRollupBucket> hours;
+        scanned_samples = 0;
+        series.scan<Kilo<Watt>>(from, to, [&](std::span<const Second> times, std::span<const Kilo<Watt>> values) {
+            for (std::size_t i = 0; i < times.size(); i++) {
+                const double hour_start = std::floor(times[i].value / 3600.0) * 3600.0;
+                if (hours.empty() || hours.back().start != hour_start) {
+                    hours.push_back({hour_start, values[i].value, values[i].value, 0, 0});
+                }
+                hours.back().add({hour_start, values[i].value, values[i].value, values[i].value, 1});
+            }
+            scanned_samples += times.size();
+        });
+        sink = hours.back().sum / static_cast<double>(hours.back().count);
+    });
+
+    const double in_memory = best_time([&] {
+        const std::size_t first = static_cast<std::size_t>(from.value - start_time);
+        std::vector<UnitRollupBucket> hours((samples - first + 3599) / 3600, UnitRollupBucket{0, 1e300, -1e300, 0, 0});
+        for (std::size_t i = first; i < samples; i++) {
+            const double kw = readings[i].value / 1000.0;
+            UnitRollupBucket& b = hours[(i - first) / 3600];
+            b.add({0, kw, kw, kw, 1});
+        }
+        sink = hours.back().sum / static_cast<double>(hours.back().count);
+    });
+
+    const double rollup_bytes = static_cast<double>(dashboard.size()) * sizeof(UnitRollupBucket);
+    const double sample_bytes = static_cast<double>(scanned_samples) * (sizeof(Second) + sizeof(Watt));
+    std::printf("%zu samples of Watt at 1 Hz, %.2e appended per second\n", samples, appended);
+    std::printf("hourly kW over %.0f days, %zu buckets\n", (to.value - from.value) / 86400.0, dashboard.size());
+    std::printf("%-34s %12s %14s\n", "", "ms", "bytes read");
+    std::printf("%-34s %12.3f %14.3e\n", "UnitSeries::rollup", rolled * 1e3, rollup_bytes);
+    std::printf("%-34s %12.3f %14.3e\n", "UnitSeries::scan", scanned * 1e3, sample_bytes);
+    std::printf("%-34s %12.3f %14.3e\n", "std::vector<Watt> in memory", in_memory * 1e3,
+            static_cast<double>(scanned_samples) * sizeof(Watt));
+    std::filesystem::remove_all(directory);
+    return series.size() == samples ? 0 : 1;
+}
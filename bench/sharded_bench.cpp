@@ -0,0 +1,96 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+// Millions of Watt * Second additions per second to one energy total from 1 thread up to every hardware thread: a
+// Joule behind a std::mutex, one AtomicUnit<Joule> every thread adds to, and a ShardedUnit<Joule> with a shard per
+// thread. The per-thread columns stay flat as threads are added when updates scale linearly.
+//     g++ -std=c++20 -O3 -march=native -pthread -I.. sharded_bench.cpp -o sharded_bench && ./sharded_bench [additions per thread]
+// UNITMAKER_BENCH_REQUIRES_CXX20
+
+#include "si_units.h"
+#include "unit_atomic.h"
+#include "unit_sharded.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// best millions of additions per second of several runs of add(i) for i in [0, per_thread) on each of threads threads
+template<typename Add>
+double time_rate(unsigned threads, std::size_t per_thread, Add add) {
+    constexpr int trials = 5;
+    double best = 0;
+    for (int t = 0; t < trials; t++) {
+        std::atomic<unsigned> ready{0};
+        std::vector<std::thread> workers;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned w = 0; w < threads; w++) {
+            workers.emplace_back([&] {
+                // every thread starts adding once all have started
+                ready.fetch_add(1);
+                while (ready.load() < threads) {
+                }
+                for (std::size_t i = 0; i < per_thread; i++) {
+                    add(i);
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        auto stop = std::chrono::steady_clock::now();
+        best = std::max(best, static_cast<double>(threads * per_thread) / std::chrono::duration<double>(stop - start).count() / 1e6);
+    }
+    return best;
+}
+
+// a millisecond of 1 to 8 kilowatt, exact in every total
+auto reading(std::size_t i) {
+    return Watt{static_cast<double>(1 + (i & 7)) * 1024} * Second{0x1.0p-10};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t per_thread = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::size_t{1} << 22;
+    const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+
+    std::printf("%zu additions per thread, M adds/s in all and per thread\n", per_thread);
+    std::printf("%-34s %12s %12s %12s %12s %12s %12s\n", "threads", "mutex", "per thread", "AtomicUnit", "per thread",
+            "ShardedUnit", "per thread");
+    bool exact = true;
+    for (unsigned threads = 1;; threads = std::min(threads * 2, hardware)) {
+        std::mutex mutex;
+        Joule locked{0};
+        const double mutex_rate = time_rate(threads, per_thread, [&](std::size_t i) {
+            std::lock_guard<std::mutex> lock{mutex};
+            locked = locked + reading(i);
+        });
+        AtomicUnit<Joule> shared;
+        const double atomic_rate = time_rate(threads, per_thread, [&](std::size_t i) {
+            shared.fetch_add(reading(i), std::memory_order_relaxed);
+        });
+        ShardedUnit<Joule> sharded;
+        const double sharded_rate = time_rate(threads, per_thread, [&](std::size_t i) {
+            sharded += reading(i);
+        });
+        // five trials of threads * per_thread readings averaging 4.5 joule
+        exact = exact && (per_thread % 8 != 0 || sharded.total().value == static_cast<double>(threads * per_thread / 8 * 36 * 5));
+        std::printf("%-34u %12.1f %12.1f %12.1f %12.1f %12.1f %12.1f\n", threads, mutex_rate, mutex_rate / threads,
+                atomic_rate, atomic_rate / threads, sharded_rate, sharded_rate / threads);
+        if (threads == hardware) {
+            break;
+        }
+    }
+    return exact ? 0 : 1;
+}
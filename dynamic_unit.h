@@ -0,0 +1,159 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_DYNAMIC_UNIT_H
+#define UNITMAKER_DYNAMIC_UNIT_H
+
+#include "units.h"
+
+#include <compare>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+
+// A quantity whose dimension is only known at runtime. The value is kept in base units (ratio 1), so a unit's scale is
+// applied once when the quantity is made, and the dimension is the same packed word as Dimension<>::packed, so
+// checking two quantities against each other is one compare. Adding or subtracting quantities of different dimensions,
+// or an exponent leaving the range of its lane, gives NaN with the mismatch dimension, which every later operation
+// keeps, so a release build finds the mistake at the end of a calculation instead of carrying on with a wrong result.
+
+// the dimension of a quantity whose calculation mixed dimensions, every exponent -128, which no unit has
+inline constexpr dimension_t dimension_mismatch = dimension_sign_bits;
+
+class DynamicUnit {
+public:
+    double value;
+    dimension_t dimension;
+
+    DynamicUnit() = default;
+
+    // value in units that are scale base units each, eg. {5, base_dimension(BaseTypes::LENGTH), 0.3048} is 5 feet
+    constexpr DynamicUnit(double v, dimension_t d, double scale = 1.0) : value{v * scale}, dimension{d} {}
+
+    template<UnitType U>
+    constexpr DynamicUnit(const U& unit)
+            : value{scale_value<ConversionFactor<typename U::ratio, std::ratio<1, 1>>, double>(unit.value)},
+              dimension{U::base_type::packed} {}
+
+    // throws std::domain_error when the dimensions differ, use to<U>() to check without throwing
+    template<UnitType U>
+    constexpr explicit operator U() const {
+        if (!is<U>()) {
+            throw std::domain_error{"DynamicUnit dimension mismatch"};
+        }
+        return unchecked<U>();
+    }
+
+    template<UnitType U>
+    constexpr std::optional<U> to() const {
+        if (!is<U>()) {
+            return std::nullopt;
+        }
+        return unchecked<U>();
+    }
+
+    // the value in U without looking at the dimension, for when it is known to match
+    template<UnitType U>
+    constexpr U unchecked() const {
+        return U{scale_value<ConversionFactor<std::ratio<1, 1>, typename U::ratio>, decltype(U::value)>(value)};
+    }
+
+    template<UnitType U>
+    constexpr bool is() const {
+        return dimension == U::base_type::packed;
+    }
+
+    // whether the calculation that gave this quantity mixed dimensions
+    constexpr bool mismatched() const {
+        return dimension == dimension_mismatch;
+    }
+
+    constexpr int exponent(BaseTypes type) const {
+        return dimension_exponent(dimension, type);
+    }
+
+    // this quantity as a multiple of unit, eg. distance.in(foot), NaN when the dimensions differ
+    constexpr double in(const DynamicUnit& unit) const {
+        if (dimension != unit.dimension || mismatched()) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        return value / unit.value;
+    }
+
+    friend constexpr bool same_dimension(const DynamicUnit& a, const DynamicUnit& b) {
+        return a.dimension == b.dimension;
+    }
+
+    friend constexpr DynamicUnit operator+(const DynamicUnit& a, const DynamicUnit& b) {
+        if (a.dimension != b.dimension) {
+            return mismatch();
+        }
+        return {a.value + b.value, a.dimension};
+    }
+
+    friend constexpr DynamicUnit operator-(const DynamicUnit& a, const DynamicUnit& b) {
+        if (a.dimension != b.dimension) {
+            return mismatch();
+        }
+        return {a.value - b.value, a.dimension};
+    }
+
+    friend constexpr DynamicUnit operator-(const DynamicUnit& a) {
+        return {-a.value, a.dimension};
+    }
+
+    friend constexpr DynamicUnit operator*(const DynamicUnit& a, const DynamicUnit& b) {
+        if (a.mismatched() || b.mismatched() || dimension_multiply_overflows(a.dimension, b.dimension)) {
+            return mismatch();
+        }
+        return {a.value * b.value, dimension_multiply(a.dimension, b.dimension)};
+    }
+
+    friend constexpr DynamicUnit operator/(const DynamicUnit& a, const DynamicUnit& b) {
+        const dimension_t inverse = dimension_inverse(b.dimension);
+        if (a.mismatched() || dimension_inverse_overflows(b.dimension)
+                || dimension_multiply_overflows(a.dimension, inverse)) {
+            return mismatch();
+        }
+        return {a.value / b.value, dimension_multiply(a.dimension, inverse)};
+    }
+
+    friend constexpr DynamicUnit operator*(const DynamicUnit& a, double s) {
+        return {a.value * s, a.dimension};
+    }
+
+    friend constexpr DynamicUnit operator*(double s, const DynamicUnit& a) {
+        return {s * a.value, a.dimension};
+    }
+
+    friend constexpr DynamicUnit operator/(const DynamicUnit& a, double s) {
+        return {a.value / s, a.dimension};
+    }
+
+    friend constexpr DynamicUnit operator/(double s, const DynamicUnit& a) {
+        if (dimension_inverse_overflows(a.dimension)) {
+            return mismatch();
+        }
+        return {s / a.value, dimension_inverse(a.dimension)};
+    }
+
+    friend constexpr bool operator==(const DynamicUnit&, const DynamicUnit&) = default;
+
+    // quantities of different dimensions are unordered
+    friend constexpr std::partial_ordering operator<=>(const DynamicUnit& a, const DynamicUnit& b) {
+        if (a.dimension != b.dimension) {
+            return std::partial_ordering::unordered;
+        }
+        return a.value <=> b.value;
+    }
+
+private:
+    static constexpr DynamicUnit mismatch() {
+        return {std::numeric_limits<double>::quiet_NaN(), dimension_mismatch};
+    }
+};
+
+static_assert(sizeof(DynamicUnit) == 16 && std::is_trivially_copyable_v<DynamicUnit>);
+
+#endif //UNITMAKER_DYNAMIC_UNIT_H
@@ -0,0 +1,166 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_MAPPED_FILE_H
+#define UNITMAKER_MAPPED_FILE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#error "mapped_file.h maps files with POSIX mmap"
+#endif
+
+// a read-only mapping of a whole file
+class MappedFile {
+public:
+    explicit MappedFile(const char* path) {
+        const int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info;
+        if (::fstat(fd, &info) == 0) {
+            size = static_cast<std::size_t>(info.st_size);
+            void* mapped = size == 0 ? nullptr : ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                data = static_cast<const char*>(mapped);
+                opened = true;
+                if (data != nullptr) {
+                    ::madvise(mapped, size, MADV_SEQUENTIAL);
+                }
+            }
+        }
+        ::close(fd);
+    }
+
+    MappedFile(MappedFile&& other) noexcept
+            : data{std::exchange(other.data, nullptr)}, size{std::exchange(other.size, 0)}, opened{other.opened} {}
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        std::swap(data, other.data);
+        std::swap(size, other.size);
+        std::swap(opened, other.opened);
+        return *this;
+    }
+
+    ~MappedFile() {
+        if (data != nullptr) {
+            ::munmap(const_cast<char*>(data), size);
+        }
+    }
+
+    std::string_view text() const {
+        return {data, size};
+    }
+
+    explicit operator bool() const {
+        return opened;
+    }
+
+    // drops the whole pages inside [first, last) from memory, they are read from the file again if touched
+    void release(const char* first, const char* last) const {
+        const std::uintptr_t page = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+        const std::uintptr_t from = (reinterpret_cast<std::uintptr_t>(first) + page - 1) & ~(page - 1);
+        const std::uintptr_t to = reinterpret_cast<std::uintptr_t>(last) & ~(page - 1);
+        if (from < to) {
+            ::madvise(reinterpret_cast<void*>(from), to - from, MADV_DONTNEED);
+        }
+    }
+
+private:
+    const char* data = nullptr;
+    std::size_t size = 0;
+    bool opened = false;
+};
+
+// a shared read-write mapping of a whole file, created when missing, whose writes reach the file
+class WritableMappedFile {
+public:
+    WritableMappedFile() = default;
+
+    // the file grown to at least minimum_size bytes, new bytes are zero
+    WritableMappedFile(const char* path, std::size_t minimum_size) : fd{::open(path, O_RDWR | O_CREAT, 0644)} {
+        struct stat info;
+        if (fd >= 0 && ::fstat(fd, &info) == 0) {
+            opened = map(std::max(static_cast<std::size_t>(info.st_size), minimum_size));
+        }
+    }
+
+    WritableMappedFile(WritableMappedFile&& other) noexcept : fd{std::exchange(other.fd, -1)},
+            data{std::exchange(other.data, nullptr)}, size{std::exchange(other.size, 0)}, opened{other.opened} {}
+
+    WritableMappedFile& operator=(WritableMappedFile&& other) noexcept {
+        std::swap(fd, other.fd);
+        std::swap(data, other.data);
+        std::swap(size, other.size);
+        std::swap(opened, other.opened);
+        return *this;
+    }
+
+    ~WritableMappedFile() {
+        unmap();
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    std::span<std::byte> bytes() const {
+        return {data, size};
+    }
+
+    explicit operator bool() const {
+        return opened;
+    }
+
+    // the file truncated or extended to new_size and mapped again, which moves bytes()
+    bool resize(std::size_t new_size) {
+        unmap();
+        opened = map(new_size);
+        return opened;
+    }
+
+    // waits for the written pages to reach the file
+    bool sync() const {
+        return data == nullptr || ::msync(data, size, MS_SYNC) == 0;
+    }
+
+private:
+    int fd = -1;
+    std::byte* data = nullptr;
+    std::size_t size = 0;
+    bool opened = false;
+
+    bool map(std::size_t new_size) {
+        if (::ftruncate(fd, static_cast<off_t>(new_size)) != 0) {
+            return false;
+        }
+        void* mapped = new_size == 0 ? nullptr : ::mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+        data = static_cast<std::byte*>(mapped);
+        size = new_size;
+        return true;
+    }
+
+    void unmap() {
+        if (data != nullptr) {
+            ::munmap(data, size);
+        }
+        data = nullptr;
+        size = 0;
+    }
+};
+
+#endif //UNITMAKER_MAPPED_FILE_H
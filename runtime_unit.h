@@ -0,0 +1,184 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_RUNTIME_UNIT_H
+#define UNITMAKER_RUNTIME_UNIT_H
+
+#if __cplusplus > 201703L
+#include "units.h"
+#else
+#include "units_17.h"
+#endif
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+// Units whose ratio to their base unit is only known while the program runs, eg. a sensor calibrated at startup. They
+// live apart from units.h, which every unit type includes, so that only code using them parses <atomic> and <mutex>;
+// like si_units.h this header works with both units.h and units_17.h.
+
+struct RuntimeRatioUpdate {
+    std::size_t slot;
+    std::intmax_t num;
+    std::intmax_t den;
+};
+
+// Conversion factors that can change while the program runs. Every reload writes a complete copy of the factors into
+// the next of Snapshots buffers and then publishes it, so readers never wait on a writer or take a lock: they only
+// retry if writers wrap all the way around to the buffer they are reading. Constant-initialized, with every factor 1.
+template<std::size_t Slots, std::size_t Snapshots = 4>
+class RuntimeRatioRegistry {
+public:
+    constexpr RuntimeRatioRegistry() : RuntimeRatioRegistry(std::make_index_sequence<Snapshots>{}) {}
+
+    RuntimeRatioRegistry(const RuntimeRatioRegistry&) = delete;
+    RuntimeRatioRegistry& operator=(const RuntimeRatioRegistry&) = delete;
+
+    // base units per unit in slot
+    double to_base(std::size_t slot) const {
+        return read([slot](const Snapshot& s) { return s.to_base[slot].load(std::memory_order_relaxed); });
+    }
+
+    // units in slot per base unit
+    double from_base(std::size_t slot) const {
+        return read([slot](const Snapshot& s) { return s.from_base[slot].load(std::memory_order_relaxed); });
+    }
+
+    // factor from the unit in one slot to the unit in another, both taken from the same reload
+    double conversion(std::size_t from, std::size_t to) const {
+        return read([from, to](const Snapshot& s) {
+            return s.to_base[from].load(std::memory_order_relaxed) * s.from_base[to].load(std::memory_order_relaxed);
+        });
+    }
+
+    // applies every update as one new version, readers see all of them or none
+    void reload(const RuntimeRatioUpdate* updates, std::size_t count) {
+        std::lock_guard<std::mutex> lock{reload_mutex};
+        const std::uint64_t current = version_.load(std::memory_order_relaxed);
+        const Snapshot& previous = snapshots[current % Snapshots];
+        Snapshot& next = snapshots[(current + 1) % Snapshots];
+
+        const std::uint64_t sequence = next.sequence.load(std::memory_order_relaxed);
+        next.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < Slots; i++) {
+            next.to_base[i].store(previous.to_base[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            next.from_base[i].store(previous.from_base[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        for (std::size_t i = 0; i < count; i++) {
+            const RuntimeRatioUpdate& u = updates[i];
+            assert(u.slot < Slots && u.num > 0 && u.den > 0 && "invalid runtime ratio");
+            const auto num = static_cast<wide_uintmax_t>(u.num);
+            const auto den = static_cast<wide_uintmax_t>(u.den);
+            next.to_base[u.slot].store(rounded_quotient(num, den), std::memory_order_relaxed);
+            next.from_base[u.slot].store(rounded_quotient(den, num), std::memory_order_relaxed);
+        }
+        next.sequence.store(sequence + 2, std::memory_order_release);
+        version_.store(current + 1, std::memory_order_release);
+    }
+
+    void reload(std::initializer_list<RuntimeRatioUpdate> updates) {
+        reload(updates.begin(), updates.size());
+    }
+
+    // number of reloads so far
+    std::uint64_t version() const {
+        return version_.load(std::memory_order_acquire);
+    }
+
+private:
+    struct Snapshot {
+        // odd while a reload is rewriting this buffer
+        std::atomic<std::uint64_t> sequence{0};
+        std::atomic<double> to_base[Slots];
+        std::atomic<double> from_base[Slots];
+
+        template<std::size_t ...I>
+        constexpr Snapshot(std::index_sequence<I...>) : to_base{((void) I, 1.0)...}, from_base{((void) I, 1.0)...} {}
+    };
+
+    template<std::size_t ...I>
+    constexpr RuntimeRatioRegistry(std::index_sequence<I...>)
+            : snapshots{((void) I, Snapshot{std::make_index_sequence<Slots>{}})...} {}
+
+    template<typename F>
+    double read(F f) const {
+        for (;;) {
+            const Snapshot& s = snapshots[version_.load(std::memory_order_acquire) % Snapshots];
+            const std::uint64_t sequence = s.sequence.load(std::memory_order_acquire);
+            if (sequence & 1) {
+                continue;
+            }
+            const double result = f(s);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.sequence.load(std::memory_order_relaxed) == sequence) {
+                return result;
+            }
+        }
+    }
+
+    Snapshot snapshots[Snapshots];
+    std::atomic<std::uint64_t> version_{0};
+    std::mutex reload_mutex;
+};
+
+inline constexpr std::size_t runtime_units_per_type = 16;
+
+// factors of every RuntimeUnit, one slot per (BaseTypes, ID)
+#if __cplusplus > 201703L
+inline constinit RuntimeRatioRegistry<(static_cast<std::size_t>(BaseTypes::CUSTOM_1) + 1) * runtime_units_per_type> runtime_ratios;
+#else
+inline RuntimeRatioRegistry<(static_cast<std::size_t>(BaseTypes::CUSTOM_1) + 1) * runtime_units_per_type> runtime_ratios;
+#endif
+
+template<BaseTypes Type, int ID, typename Numeric = double>
+struct RuntimeUnit {
+    static_assert(ID >= 0 && ID < static_cast<int>(runtime_units_per_type), "RuntimeUnit ID must be below runtime_units_per_type");
+    static constexpr std::size_t slot = static_cast<std::size_t>(Type) * runtime_units_per_type + ID;
+
+    Numeric value;
+    explicit constexpr RuntimeUnit(Numeric v): value(v) {}
+
+#if __cplusplus > 201703L
+    template<UnitType T>
+    requires EquivalentBaseType<T, RuntimeUnit<Type, ID>>
+#else
+    template<typename T, class = typename std::enable_if_t<has_equivalent_base_type_v<T, RuntimeUnit<Type, ID>>>>
+#endif
+    explicit RuntimeUnit(T other): value{static_cast<Numeric>(Unit<Type>{other}.value * runtime_ratios.from_base(slot))} {}
+
+#if __cplusplus > 201703L
+    template<UnitType T>
+    requires EquivalentBaseType<RuntimeUnit<Type, ID>, T>
+#else
+    template<typename T, class = typename std::enable_if_t<has_equivalent_base_type_v<T, RuntimeUnit<Type, ID>>>>
+#endif
+    operator T() const {
+        return T{Unit<Type>{value * runtime_ratios.to_base(slot)}};
+    }
+
+    // one RuntimeUnit's ratio to its base unit, use runtime_ratios.reload to change several at once
+    static void set_ratio(std::intmax_t num, std::intmax_t den) {
+        runtime_ratios.reload({{slot, num, den}});
+    }
+
+    static RuntimeRatioUpdate ratio_update(std::intmax_t num, std::intmax_t den) {
+        return {slot, num, den};
+    }
+
+    using base_type = BaseDimension<Type>;
+    // the factor lives in runtime_ratios, these are never defined so that compile-time conversions through them fail
+    struct ratio {
+        static const std::intmax_t num;
+        static const std::intmax_t den;
+    };
+};
+
+#endif //UNITMAKER_RUNTIME_UNIT_H
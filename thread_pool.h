@@ -0,0 +1,127 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_THREAD_POOL_H
+#define UNITMAKER_THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// threads kept waiting for runs of numbered tasks, so parallel loops do not pay for starting threads on every call
+class ThreadPool {
+public:
+    // threads - 1 workers, the thread calling run being the last
+    explicit ThreadPool(unsigned threads = std::max(1u, std::thread::hardware_concurrency())) {
+        for (unsigned i = 1; i < threads; i++) {
+            workers.emplace_back([this] {
+                work();
+            });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& t : workers) {
+            t.join();
+        }
+    }
+
+    unsigned size() const {
+        return static_cast<unsigned>(workers.size()) + 1;
+    }
+
+    // f(i) for every i in [0, tasks) on the workers and the calling thread, each taking the next task from a shared
+    // counter when it finishes one, so uneven tasks even out; returns once every task has run. Runs from several
+    // threads take turns, and a task must not start a run on its own pool.
+    template<typename F>
+    void run(std::size_t tasks, F&& f) {
+        using function_t = std::remove_reference_t<F>;
+        std::lock_guard<std::mutex> turn{running};
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            job = {const_cast<void*>(static_cast<const void*>(&f)), [](void* f, std::size_t i) {
+                (*static_cast<function_t*>(f))(i);
+            }, tasks};
+            next = 0;
+            busy = workers.size();
+            generation++;
+        }
+        wake.notify_all();
+        claim(job);
+        std::unique_lock<std::mutex> lock{mutex};
+        finished.wait(lock, [this] {
+            return busy == 0;
+        });
+    }
+
+private:
+    struct Job {
+        void* f = nullptr;
+        void (*invoke)(void*, std::size_t) = nullptr;
+        std::size_t tasks = 0;
+    };
+
+    std::vector<std::thread> workers;
+    std::mutex running;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    Job job;
+    std::atomic<std::size_t> next{0};
+    std::size_t busy = 0;
+    std::uint64_t generation = 0;
+    bool stopping = false;
+
+    void claim(const Job& j) {
+        for (std::size_t i = next.fetch_add(1, std::memory_order_relaxed); i < j.tasks; i = next.fetch_add(1, std::memory_order_relaxed)) {
+            j.invoke(j.f, i);
+        }
+    }
+
+    // every worker takes part in every run, which cannot end before each has counted itself out of it
+    void work() {
+        std::uint64_t seen = 0;
+        for (;;) {
+            Job j;
+            {
+                std::unique_lock<std::mutex> lock{mutex};
+                wake.wait(lock, [&] {
+                    return stopping || generation != seen;
+                });
+                if (stopping) {
+                    return;
+                }
+                seen = generation;
+                j = job;
+            }
+            claim(j);
+            std::lock_guard<std::mutex> lock{mutex};
+            if (--busy == 0) {
+                finished.notify_one();
+            }
+        }
+    }
+};
+
+// shared by everything run under a parallel execution policy
+inline ThreadPool& default_thread_pool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+#endif //UNITMAKER_THREAD_POOL_H
@@ -0,0 +1,246 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_UNIT_ACCUMULATE_H
+#define UNITMAKER_UNIT_ACCUMULATE_H
+
+#include "unit_reduce.h"
+#include "units.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+
+// Running totals of a floating point unit that are added to one reading at a time, for meters that sum billions of
+// readings where total = total + reading drifts. Each accepts any unit of the same dimension, multiplied by the
+// conversion factor as it is added, so Milli<Joule> readings go into a Joule total without a unit_cast per reading.
+// From fastest to most accurate:
+//     CompensatedSum - Neumaier's variant of Kahan summation, the error no longer grows with the number of readings
+//     PairwiseSum    - readings summed in blocks of 128 and the blocks in pairs, the error grows with its logarithm
+//     ExactSum       - every reading held exactly in a fixed point number spanning all doubles, rounded only once
+
+template<UnitType U, UnitType V>
+requires EquivalentBaseType<U, V> && std::floating_point<decltype(U::value)>
+decltype(U::value) accumulated_value(const V& x) {
+    using numeric_t = decltype(U::value);
+    constexpr double factor = ConversionFactor<typename V::ratio, typename U::ratio>::value;
+    if constexpr (factor == 1.0) {
+        return static_cast<numeric_t>(x.value);
+    } else {
+        return static_cast<numeric_t>(x.value * factor);
+    }
+}
+
+template<UnitType U>
+requires std::floating_point<decltype(U::value)>
+class CompensatedSum {
+public:
+    using unit_type = U;
+
+    template<UnitType V>
+    requires EquivalentBaseType<U, V>
+    CompensatedSum& operator+=(const V& x) {
+        const numeric_t value = accumulated_value<U>(x);
+        const numeric_t t = sum + value;
+        // the low bits lost by whichever of the two is smaller
+        compensation += std::fabs(sum) >= std::fabs(value) ? (sum - t) + value : (value - t) + sum;
+        sum = t;
+        return *this;
+    }
+
+    U total() const {
+        return U{sum + compensation};
+    }
+
+private:
+    using numeric_t = decltype(U::value);
+
+    numeric_t sum = 0;
+    numeric_t compensation = 0;
+};
+
+template<UnitType U>
+requires std::floating_point<decltype(U::value)>
+class PairwiseSum {
+public:
+    using unit_type = U;
+
+    template<UnitType V>
+    requires EquivalentBaseType<U, V>
+    PairwiseSum& operator+=(const V& x) {
+        buffer[buffered++] = accumulated_value<U>(x);
+        if (buffered == block) {
+            add_block();
+        }
+        return *this;
+    }
+
+    U total() const {
+        numeric_t sum = pairwise_sum<numeric_t>(0, buffered, [&](std::size_t i) {
+            return buffer[i];
+        });
+        // the partial sums from the fewest blocks to the most, so the small ones are not lost in the large
+        for (std::size_t level = 0; level < levels; level++) {
+            if ((blocks >> level & 1) != 0) {
+                sum = partial[level] + sum;
+            }
+        }
+        return U{sum};
+    }
+
+private:
+    using numeric_t = decltype(U::value);
+
+    static constexpr std::size_t block = 128;
+    static constexpr std::size_t levels = 64;
+
+    numeric_t buffer[block];
+    std::size_t buffered = 0;
+    // partial[level] is the sum of 2^level blocks when that bit of blocks is set, like the digits of a binary counter
+    numeric_t partial[levels];
+    std::uint64_t blocks = 0;
+
+    void add_block() {
+        numeric_t sum = pairwise_sum<numeric_t>(0, block, [&](std::size_t i) {
+            return buffer[i];
+        });
+        std::size_t level = 0;
+        for (; (blocks >> level & 1) != 0; level++) {
+            sum = partial[level] + sum;
+        }
+        partial[level] = sum;
+        blocks++;
+        buffered = 0;
+    }
+};
+
+// A fixed point number of 32 bit digits from 2^-1074, the smallest double, to past the largest, holding the sum of the
+// readings without rounding. Each reading adds its 53 bit significand to the three digits it overlaps; digits carry
+// into the next only when the total is read or once every 2^30 readings, before they could overflow. Infinities and
+// NaN are summed apart and win over the finite sum, as they would in a running sum.
+template<UnitType U>
+requires std::same_as<decltype(U::value), double> || std::same_as<decltype(U::value), float>
+class ExactSum {
+public:
+    using unit_type = U;
+
+    template<UnitType V>
+    requires EquivalentBaseType<U, V>
+    ExactSum& operator+=(const V& x) {
+        const double value = accumulated_value<U>(x);
+        const std::uint64_t bits = std::bit_cast<std::uint64_t>(value);
+        const std::uint64_t exponent = bits >> 52 & 0x7ff;
+        if (exponent == 0x7ff) {
+            special += value;
+            return *this;
+        }
+        // value is significand * 2^(position - 1074), subnormals having no implicit bit and the exponent of 1
+        const std::uint64_t fraction = bits & ((std::uint64_t{1} << 52) - 1);
+        const std::uint64_t significand = exponent == 0 ? fraction : fraction | std::uint64_t{1} << 52;
+        const std::uint64_t position = exponent == 0 ? 0 : exponent - 1;
+        const std::size_t digit = position / digit_bits;
+        const unsigned shift = position % digit_bits;
+        const std::uint64_t above = significand >> (digit_bits - shift);
+        const std::int64_t low = static_cast<std::int64_t>(significand << shift & digit_mask);
+        const std::int64_t middle = static_cast<std::int64_t>(above & digit_mask);
+        const std::int64_t high = static_cast<std::int64_t>(above >> digit_bits);
+        if ((bits >> 63) != 0) {
+            digits[digit] -= low;
+            digits[digit + 1] -= middle;
+            digits[digit + 2] -= high;
+        } else {
+            digits[digit] += low;
+            digits[digit + 1] += middle;
+            digits[digit + 2] += high;
+        }
+        if (++pending == carry_interval) {
+            carry(digits);
+            pending = 0;
+        }
+        return *this;
+    }
+
+    // the exact sum rounded to the nearest double, ties to even
+    U total() const {
+        using numeric_t = decltype(U::value);
+        if (special != 0) {
+            return U{static_cast<numeric_t>(special)};
+        }
+        std::int64_t d[count];
+        std::ranges::copy(digits, d);
+        carry(d);
+        const bool negative = d[count - 1] < 0;
+        if (negative) {
+            for (std::int64_t& x : d) {
+                x = -x;
+            }
+            carry(d);
+        }
+        std::size_t next = count;
+        while (next > 0 && d[next - 1] == 0) {
+            next--;
+        }
+        if (next == 0) {
+            return U{0};
+        }
+        // the 64 bits from the highest set one down, d[next] being the lowest digit taken, and whether any bit below
+        // them is set, which decides a tie between two doubles
+        std::uint64_t head = static_cast<std::uint64_t>(d[--next]);
+        int exponent = static_cast<int>(next * digit_bits) - 1074;
+        while (next > 0 && std::countl_zero(head) >= static_cast<int>(digit_bits)) {
+            head = head << digit_bits | static_cast<std::uint64_t>(d[--next]);
+            exponent -= static_cast<int>(digit_bits);
+        }
+        bool sticky = false;
+        if (next > 0) {
+            const int room = std::countl_zero(head);
+            const std::uint64_t digit = static_cast<std::uint64_t>(d[--next]);
+            if (room > 0) {
+                head = head << room | digit >> (digit_bits - room);
+                exponent -= room;
+            }
+            sticky = (digit & ((std::uint64_t{1} << (digit_bits - room)) - 1)) != 0;
+        }
+        for (std::size_t i = 0; i < next; i++) {
+            sticky = sticky || d[i] != 0;
+        }
+        const int dropped = std::max(static_cast<int>(std::bit_width(head)) - 53, 0);
+        std::uint64_t significand = head >> dropped;
+        if (dropped > 0) {
+            const std::uint64_t rest = head & ((std::uint64_t{1} << dropped) - 1);
+            const std::uint64_t half = std::uint64_t{1} << (dropped - 1);
+            if (rest > half || (rest == half && (sticky || (significand & 1) != 0))) {
+                significand++;
+            }
+        }
+        // a subnormal total fits in head without rounding, so it is not rounded twice; ldexp overflows to infinity
+        const double magnitude = std::ldexp(static_cast<double>(significand), exponent + dropped);
+        return U{static_cast<numeric_t>(negative ? -magnitude : magnitude)};
+    }
+
+private:
+    static constexpr std::size_t digit_bits = 32;
+    static constexpr std::int64_t digit_mask = (std::int64_t{1} << digit_bits) - 1;
+    // 2098 bits of doubles, the three digits a significand at the top can reach and room for the carries of 2^64 more
+    static constexpr std::size_t count = (2098 + digit_bits - 1) / digit_bits + 2 + 2;
+    static constexpr std::uint32_t carry_interval = std::uint32_t{1} << 30;
+
+    std::int64_t digits[count]{};
+    std::uint32_t pending = 0;
+    double special = 0;
+
+    // every digit but the last brought into [0, 2^32), the last keeping the sign
+    static void carry(std::int64_t (&d)[count]) {
+        for (std::size_t i = 0; i + 1 < count; i++) {
+            const std::int64_t c = d[i] >> digit_bits;
+            d[i] -= c * (std::int64_t{1} << digit_bits);
+            d[i + 1] += c;
+        }
+    }
+};
+
+#endif //UNITMAKER_UNIT_ACCUMULATE_H
@@ -0,0 +1,359 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_UNIT_ARRAY_H
+#define UNITMAKER_UNIT_ARRAY_H
+
+#include "units.h"
+#include "unit_convert.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <new>
+#include <span>
+#include <vector>
+
+// UnitArray<U> keeps the values of many U contiguously and applies the scalar operators from units.h to all of them
+// at once. Result types and dimension checks are the ones the scalar operators would produce for a single element.
+
+inline constexpr std::size_t unit_array_alignment = 64;
+
+// allocates on unit_array_alignment boundaries and default-initializes, so sizing an output buffer doesn't zero it
+template<typename T>
+struct AlignedAllocator {
+    using value_type = T;
+
+    AlignedAllocator() = default;
+
+    template<typename V>
+    constexpr AlignedAllocator(const AlignedAllocator<V>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{unit_array_alignment}));
+    }
+
+    void deallocate(T* p, std::size_t) noexcept {
+        ::operator delete(p, std::align_val_t{unit_array_alignment});
+    }
+
+    template<typename V, typename ...Args>
+    void construct(V* p, Args&& ...args) {
+        if constexpr (sizeof...(Args) == 0) {
+            ::new(static_cast<void*>(p)) V;
+        } else {
+            ::new(static_cast<void*>(p)) V(std::forward<Args>(args)...);
+        }
+    }
+
+    template<typename V>
+    friend constexpr bool operator==(const AlignedAllocator&, const AlignedAllocator<V>&) noexcept {
+        return true;
+    }
+};
+
+using UnitArrayMask = std::vector<std::uint8_t, AlignedAllocator<std::uint8_t>>;
+
+template<UnitType U>
+class UnitArray {
+public:
+    using unit_type = U;
+    using value_type = decltype(U::value);
+
+    template<UnitType V>
+    using rebind = UnitArray<V>;
+
+    UnitArray() = default;
+
+    explicit UnitArray(std::size_t count) : values_(count, value_type{}) {}
+
+    UnitArray(std::initializer_list<U> units) {
+        values_.reserve(units.size());
+        for (const U& u : units) {
+            values_.push_back(u.value);
+        }
+    }
+
+    // converts every element, like the implicit conversion between single units
+    template<UnitType From>
+    requires EquivalentBaseType<U, From> && (!std::same_as<U, From>)
+    UnitArray(const UnitArray<From>& other) : UnitArray(uninitialized(other.size())) {
+        convert_values<From, U>(other.values().data(), data(), size());
+    }
+
+    // the buffer is allocated but the values are left for the caller to write
+    static UnitArray uninitialized(std::size_t count) {
+        UnitArray array;
+        array.values_.resize(count);
+        return array;
+    }
+
+    U operator[](std::size_t i) const {
+        return U{values_[i]};
+    }
+
+    template<UnitType V>
+    requires EquivalentBaseType<U, V>
+    void set(std::size_t i, const V& unit) {
+        values_[i] = unit_cast<U>(unit).value;
+    }
+
+    template<UnitType V>
+    requires EquivalentBaseType<U, V>
+    void push_back(const V& unit) {
+        values_.push_back(unit_cast<U>(unit).value);
+    }
+
+    std::span<value_type> values() { return values_; }
+    std::span<const value_type> values() const { return values_; }
+    value_type* data() { return values_.data(); }
+    const value_type* data() const { return values_.data(); }
+    std::size_t size() const { return values_.size(); }
+    bool empty() const { return values_.empty(); }
+    std::size_t capacity() const { return values_.capacity(); }
+    void reserve(std::size_t count) { values_.reserve(count); }
+    void resize(std::size_t count) { values_.resize(count, value_type{}); }
+    void clear() { values_.clear(); }
+
+private:
+    std::vector<value_type, AlignedAllocator<value_type>> values_;
+};
+
+// same interface as UnitArray with in-place storage for at most Capacity elements, results of operators on it keep
+// the same capacity
+template<UnitType U, std::size_t Capacity>
+class FixedUnitArray {
+public:
+    using unit_type = U;
+    using value_type = decltype(U::value);
+
+    template<UnitType V>
+    using rebind = FixedUnitArray<V, Capacity>;
+
+    FixedUnitArray() = default;
+
+    explicit FixedUnitArray(std::size_t count) : count_{count} {
+        assert(count <= Capacity && "FixedUnitArray capacity exceeded");
+        std::fill_n(values_, count, value_type{});
+    }
+
+    FixedUnitArray(std::initializer_list<U> units) {
+        for (const U& u : units) {
+            push_back(u);
+        }
+    }
+
+    template<UnitType From, std::size_t OtherCapacity>
+    requires EquivalentBaseType<U, From> && (!std::same_as<U, From>)
+    FixedUnitArray(const FixedUnitArray<From, OtherCapacity>& other) : FixedUnitArray(uninitialized(other.size())) {
+        convert_values<From, U>(other.values().data(), data(), size());
+    }
+
+    static FixedUnitArray uninitialized(std::size_t count) {
+        assert(count <= Capacity && "FixedUnitArray capacity exceeded");
+        FixedUnitArray array;
+        array.count_ = count;
+        return array;
+    }
+
+    U operator[](std::size_t i) const {
+        return U{values_[i]};
+    }
+
+    template<UnitType V>
+    requires EquivalentBaseType<U, V>
+    void set(std::size_t i, const V& unit) {
+        values_[i] = unit_cast<U>(unit).value;
+    }
+
+    template<UnitType V>
+    requires EquivalentBaseType<U, V>
+    void push_back(const V& unit) {
+        assert(count_ < Capacity && "FixedUnitArray capacity exceeded");
+        values_[count_++] = unit_cast<U>(unit).value;
+    }
+
+    std::span<value_type> values() { return {values_, count_}; }
+    std::span<const value_type> values() const { return {values_, count_}; }
+    value_type* data() { return values_; }
+    const value_type* data() const { return values_; }
+    std::size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    static constexpr std::size_t capacity() { return Capacity; }
+    void resize(std::size_t count) {
+        assert(count <= Capacity && "FixedUnitArray capacity exceeded");
+        if (count > count_) {
+            std::fill(values_ + count_, values_ + count, value_type{});
+        }
+        count_ = count;
+    }
+    void clear() { count_ = 0; }
+
+private:
+    alignas(unit_array_alignment) value_type values_[Capacity];
+    std::size_t count_ = 0;
+};
+
+template<typename A>
+concept UnitArrayType = UnitType<typename A::unit_type> && requires(const A& a) {
+    { a.size() } -> std::same_as<std::size_t>;
+    { a.data() } -> std::same_as<const typename A::value_type*>;
+    A::uninitialized(std::size_t{});
+};
+
+// applies the scalar operator to each pair of elements, through a kernel when every operand and the result share a
+// float or double Numeric. For sums and extrema the right operand's conversion to the result ratio is folded into k.
+template<ArrayOp Op, typename Result, UnitArrayType A1, UnitArrayType A2, typename ScalarOp>
+auto array_elementwise(const A1& a, const A2& b, ScalarOp scalar_op) {
+    using U1 = typename A1::unit_type;
+    using U2 = typename A2::unit_type;
+    using result_array = typename A1::template rebind<Result>;
+    using value_t = decltype(Result::value);
+    assert(a.size() == b.size() && "UnitArray sizes differ");
+
+    result_array out = result_array::uninitialized(a.size());
+    constexpr bool same_ratio = std::ratio_equal_v<typename U1::ratio, typename Result::ratio>;
+    if constexpr (std::is_same_v<typename A1::value_type, value_t> && std::is_same_v<typename A2::value_type, value_t>
+            && array_kernel_type<value_t> && (same_ratio || Op == ArrayOp::MULTIPLY || Op == ArrayOp::DIVIDE)) {
+        double k = 1;
+        if constexpr (Op != ArrayOp::MULTIPLY && Op != ArrayOp::DIVIDE) {
+            k = ConversionFactor<typename U2::ratio, typename Result::ratio>::value;
+        }
+        array_binary(Op, a.data(), b.data(), k, out.data(), a.size());
+    } else {
+        for (std::size_t i = 0; i < a.size(); i++) {
+            out.data()[i] = unit_cast<Result>(scalar_op(a[i], b[i])).value;
+        }
+    }
+    return out;
+}
+
+template<ArrayOp Op, typename Result, UnitArrayType A, typename S, typename ScalarOp>
+auto array_with_scalar(const A& a, S s, ScalarOp scalar_op) {
+    using result_array = typename A::template rebind<Result>;
+    using value_t = decltype(Result::value);
+
+    result_array out = result_array::uninitialized(a.size());
+    if constexpr (std::is_same_v<typename A::value_type, value_t> && std::is_same_v<S, value_t> && array_kernel_type<value_t>) {
+        array_scalar(Op, a.data(), s, out.data(), a.size());
+    } else {
+        for (std::size_t i = 0; i < a.size(); i++) {
+            out.data()[i] = scalar_op(a[i], s).value;
+        }
+    }
+    return out;
+}
+
+template<UnitArrayType A1, UnitArrayType A2>
+requires EquivalentBaseType<typename A1::unit_type, typename A2::unit_type>
+auto operator+(const A1& a, const A2& b) {
+    using result_t = typename SumUnit<typename A1::unit_type, typename A2::unit_type>::type;
+    return array_elementwise<ArrayOp::ADD, result_t>(a, b, [](const auto& x, const auto& y) { return x + y; });
+}
+
+template<UnitArrayType A1, UnitArrayType A2>
+requires EquivalentBaseType<typename A1::unit_type, typename A2::unit_type>
+auto operator-(const A1& a, const A2& b) {
+    using result_t = typename SumUnit<typename A1::unit_type, typename A2::unit_type>::type;
+    return array_elementwise<ArrayOp::SUBTRACT, result_t>(a, b, [](const auto& x, const auto& y) { return x - y; });
+}
+
+template<UnitArrayType A1, UnitArrayType A2>
+auto operator*(const A1& a, const A2& b) {
+    using result_t = decltype(std::declval<typename A1::unit_type>() * std::declval<typename A2::unit_type>());
+    return array_elementwise<ArrayOp::MULTIPLY, result_t>(a, b, [](const auto& x, const auto& y) { return x * y; });
+}
+
+template<UnitArrayType A1, UnitArrayType A2>
+auto operator/(const A1& a, const A2& b) {
+    using result_t = decltype(std::declval<typename A1::unit_type>() / std::declval<typename A2::unit_type>());
+    return array_elementwise<ArrayOp::DIVIDE, result_t>(a, b, [](const auto& x, const auto& y) { return x / y; });
+}
+
+template<UnitArrayType A, typename S>
+requires std::is_arithmetic_v<S>
+auto operator*(const A& a, S s) {
+    using result_t = decltype(std::declval<typename A::unit_type>() * s);
+    return array_with_scalar<ArrayOp::MULTIPLY, result_t>(a, s, [](const auto& x, S y) { return x * y; });
+}
+
+template<typename S, UnitArrayType A>
+requires std::is_arithmetic_v<S>
+auto operator*(S s, const A& a) {
+    return a * s;
+}
+
+template<UnitArrayType A, typename S>
+requires std::is_arithmetic_v<S>
+auto operator/(const A& a, S s) {
+    using result_t = decltype(std::declval<typename A::unit_type>() / s);
+    return array_with_scalar<ArrayOp::DIVIDE, result_t>(a, s, [](const auto& x, S y) { return x / y; });
+}
+
+template<typename S, UnitArrayType A>
+requires std::is_arithmetic_v<S>
+auto operator/(S s, const A& a) {
+    using result_t = decltype(s / std::declval<typename A::unit_type>());
+    return array_with_scalar<ArrayOp::DIVIDE_INTO, result_t>(a, s, [](const auto& x, S y) { return y / x; });
+}
+
+// the right operand is converted to the left operand's unit before comparing, the way unit_cast would convert it
+template<CompareOp Op, UnitArrayType A1, UnitArrayType A2>
+requires EquivalentBaseType<typename A1::unit_type, typename A2::unit_type>
+UnitArrayMask compare(const A1& a, const A2& b) {
+    using U1 = typename A1::unit_type;
+    using value_t = typename A1::value_type;
+    assert(a.size() == b.size() && "UnitArray sizes differ");
+
+    UnitArrayMask mask(a.size());
+    if constexpr (std::is_same_v<value_t, typename A2::value_type> && array_kernel_type<value_t>) {
+        constexpr double k = ConversionFactor<typename A2::unit_type::ratio, typename U1::ratio>::value;
+        array_compare(Op, a.data(), b.data(), k, mask.data(), a.size());
+    } else {
+        for (std::size_t i = 0; i < a.size(); i++) {
+            mask[i] = apply_compare_op<Op>(a.data()[i], unit_cast<U1>(b[i]).value);
+        }
+    }
+    return mask;
+}
+
+template<UnitArrayType A1, UnitArrayType A2>
+requires EquivalentBaseType<typename A1::unit_type, typename A2::unit_type>
+auto min(const A1& a, const A2& b) {
+    return array_elementwise<ArrayOp::MIN, typename A1::unit_type>(a, b, [](const auto& x, const auto& y) {
+        const auto converted = unit_cast<std::remove_cvref_t<decltype(x)>>(y);
+        return converted.value < x.value ? converted : x;
+    });
+}
+
+template<UnitArrayType A1, UnitArrayType A2>
+requires EquivalentBaseType<typename A1::unit_type, typename A2::unit_type>
+auto max(const A1& a, const A2& b) {
+    return array_elementwise<ArrayOp::MAX, typename A1::unit_type>(a, b, [](const auto& x, const auto& y) {
+        const auto converted = unit_cast<std::remove_cvref_t<decltype(x)>>(y);
+        return x.value < converted.value ? converted : x;
+    });
+}
+
+template<UnitArrayType A, UnitType Low, UnitType High>
+requires EquivalentBaseType<typename A::unit_type, Low> && EquivalentBaseType<typename A::unit_type, High>
+A clamp(const A& a, const Low& low, const High& high) {
+    using U = typename A::unit_type;
+    using value_t = typename A::value_type;
+    const value_t lo = unit_cast<U>(low).value;
+    const value_t hi = unit_cast<U>(high).value;
+
+    A out = A::uninitialized(a.size());
+    if constexpr (array_kernel_type<value_t>) {
+        array_clamp(a.data(), lo, hi, out.data(), a.size());
+    } else {
+        for (std::size_t i = 0; i < a.size(); i++) {
+            out.data()[i] = std::clamp(a.data()[i], lo, hi);
+        }
+    }
+    return out;
+}
+
+#endif //UNITMAKER_UNIT_ARRAY_H
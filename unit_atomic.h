@@ -0,0 +1,139 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_UNIT_ATOMIC_H
+#define UNITMAKER_UNIT_ATOMIC_H
+
+#include "units.h"
+
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+// Units shared between threads without a mutex, eg. the Joule or Liter counted by every worker. AtomicUnit<U> holds
+// its value in a std::atomic of U's numeric type; AtomicUnitRef<U> makes a U that lives elsewhere atomic through
+// std::atomic_ref while it is in use. Operands of any unit of the same dimension are converted to U first, as unit_cast
+// would. Integral units add with the hardware's fetch_add; floating point units with a compare-exchange loop, which is
+// what the hardware offers for them.
+
+// what data written by different threads is aligned to, so that no two threads write to the same cache line
+inline constexpr std::size_t unit_cache_line = 64;
+
+template<UnitType U, typename Atomic>
+requires std::is_arithmetic_v<decltype(U::value)>
+class AtomicUnitOperations {
+public:
+    using unit_type = U;
+
+    static constexpr bool is_always_lock_free = Atomic::is_always_lock_free;
+
+    bool is_lock_free() const {
+        return atomic.is_lock_free();
+    }
+
+    U load(std::memory_order order = std::memory_order_seq_cst) const {
+        return U{atomic.load(order)};
+    }
+
+    operator U() const {
+        return load();
+    }
+
+    template<UnitType V>
+    requires EquivalentBaseType<U, V>
+    void store(const V& x, std::memory_order order = std::memory_order_seq_cst) {
+        atomic.store(unit_cast<U>(x).value, order);
+    }
+
+    template<UnitType V>
+    requires EquivalentBaseType<U, V>
+    U exchange(const V& x, std::memory_order order = std::memory_order_seq_cst) {
+        return U{atomic.exchange(unit_cast<U>(x).value, order)};
+    }
+
+    // on failure expected is set to the value found, as with std::atomic
+    template<UnitType V>
+    requires EquivalentBaseType<U, V>
+    bool compare_exchange_weak(U& expected, const V& desired, std::memory_order order = std::memory_order_seq_cst) {
+        return atomic.compare_exchange_weak(expected.value, unit_cast<U>(desired).value, order);
+    }
+
+    template<UnitType V>
+    requires EquivalentBaseType<U, V>
+    bool compare_exchange_strong(U& expected, const V& desired, std::memory_order order = std::memory_order_seq_cst) {
+        return atomic.compare_exchange_strong(expected.value, unit_cast<U>(desired).value, order);
+    }
+
+    // the value before x was added
+    template<UnitType V>
+    requires EquivalentBaseType<U, V>
+    U fetch_add(const V& x, std::memory_order order = std::memory_order_seq_cst) {
+        return U{add(unit_cast<U>(x).value, order)};
+    }
+
+    template<UnitType V>
+    requires EquivalentBaseType<U, V>
+    U fetch_sub(const V& x, std::memory_order order = std::memory_order_seq_cst) {
+        return U{add(static_cast<numeric_t>(-unit_cast<U>(x).value), order)};
+    }
+
+    // the value after x was added
+    template<UnitType V>
+    requires EquivalentBaseType<U, V>
+    U operator+=(const V& x) {
+        const numeric_t delta = unit_cast<U>(x).value;
+        return U{static_cast<numeric_t>(add(delta, std::memory_order_seq_cst) + delta)};
+    }
+
+    template<UnitType V>
+    requires EquivalentBaseType<U, V>
+    U operator-=(const V& x) {
+        const numeric_t delta = static_cast<numeric_t>(-unit_cast<U>(x).value);
+        return U{static_cast<numeric_t>(add(delta, std::memory_order_seq_cst) + delta)};
+    }
+
+protected:
+    using numeric_t = decltype(U::value);
+
+    Atomic atomic;
+
+    template<typename... Args>
+    explicit AtomicUnitOperations(Args&&... args) : atomic{std::forward<Args>(args)...} {}
+
+private:
+    numeric_t add(numeric_t delta, std::memory_order order) {
+        if constexpr (std::integral<numeric_t>) {
+            return atomic.fetch_add(delta, order);
+        } else {
+            // a failed exchange reloads current, so each retry adds to what another thread just stored
+            numeric_t current = atomic.load(std::memory_order_relaxed);
+            while (!atomic.compare_exchange_weak(current, current + delta, order, std::memory_order_relaxed)) {
+            }
+            return current;
+        }
+    }
+};
+
+template<UnitType U>
+class AtomicUnit : public AtomicUnitOperations<U, std::atomic<decltype(U::value)>> {
+public:
+    explicit AtomicUnit(U initial = U{0}) : AtomicUnitOperations<U, std::atomic<decltype(U::value)>>{initial.value} {}
+
+    AtomicUnit(const AtomicUnit&) = delete;
+    AtomicUnit& operator=(const AtomicUnit&) = delete;
+};
+
+// every access to the referenced unit must be atomic for as long as any AtomicUnitRef to it exists
+template<UnitType U>
+class AtomicUnitRef : public AtomicUnitOperations<U, std::atomic_ref<decltype(U::value)>> {
+public:
+    static_assert(alignof(U) >= std::atomic_ref<decltype(U::value)>::required_alignment,
+            "Unit is not aligned enough for std::atomic_ref");
+
+    explicit AtomicUnitRef(U& unit) : AtomicUnitOperations<U, std::atomic_ref<decltype(U::value)>>{unit.value} {}
+};
+
+#endif //UNITMAKER_UNIT_ATOMIC_H
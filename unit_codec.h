@@ -0,0 +1,466 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_UNIT_CODEC_H
+#define UNITMAKER_UNIT_CODEC_H
+
+#include "unit_convert.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+// Compressed blocks of unit samples. Each block starts with a header giving the unit's dimension, ratio, offset and
+// numeric type once, followed by a bit stream: floating-point samples are XOR coded against the previous sample as in
+// Gorilla, integer and fixed-point samples, and floating-point ones that are all whole numbers such as timestamps in
+// Second, are delta-of-delta coded. Samples that would come out larger than they went in, such as noisy readings, are
+// stored as they are. Decoding into another unit of the same dimension applies the conversion to each
+// sample as it comes out of the stream.
+
+enum class UnitCodecError {
+    NONE, FORMAT, DIMENSION_MISMATCH, OUTPUT_TOO_SMALL
+};
+
+enum class UnitCodecEncoding : std::uint8_t {
+    XOR, DELTA_OF_DELTA, RAW
+};
+
+struct UnitBlockHeader {
+    char magic[4];
+    // 0x01020304 as the writer stored it
+    std::uint32_t byte_order;
+    std::uint32_t count;
+    UnitCodecEncoding encoding;
+    UnitNumericKind numeric;
+    std::uint8_t fixed;
+    std::uint8_t fractional_bits;
+    dimension_t dimension;
+    std::int64_t num;
+    std::int64_t den;
+    std::int64_t offset_num;
+    std::int64_t offset_den;
+    // bytes of bit stream after the header, whole 64-bit words
+    std::uint64_t payload;
+};
+
+static_assert(sizeof(UnitBlockHeader) == 64 && std::is_trivially_copyable_v<UnitBlockHeader>);
+
+inline constexpr char unit_block_magic[4] = {'U', 'B', 'L', 'K'};
+
+struct UnitDecodeResult {
+    UnitCodecError error = UnitCodecError::NONE;
+    // written to the front of the output
+    std::size_t values = 0;
+    // bytes of the block, where the next one starts
+    std::size_t consumed = 0;
+
+    explicit operator bool() const {
+        return error == UnitCodecError::NONE;
+    }
+};
+
+// bits appended most significant first, whole words at a time
+class UnitBitWriter {
+public:
+    explicit UnitBitWriter(std::vector<std::byte>& out) : out{out} {}
+
+    // the low n bits of bits, 1 <= n <= 64
+    void put(std::uint64_t bits, int n) {
+        bits &= ~std::uint64_t{0} >> (64 - n);
+        if (filled + n < 64) {
+            word = word << n | bits;
+            filled += n;
+            return;
+        }
+        const int rest = filled + n - 64;
+        word = (filled == 0 ? 0 : word << (64 - filled)) | bits >> rest;
+        flush();
+        word = bits;
+        filled = rest;
+    }
+
+    // the last partial word, padded with zeros
+    void finish() {
+        if (filled != 0) {
+            word <<= 64 - filled;
+            flush();
+            filled = 0;
+        }
+    }
+
+private:
+    std::vector<std::byte>& out;
+    std::uint64_t word = 0;
+    int filled = 0;
+
+    void flush() {
+        const std::size_t at = out.size();
+        out.resize(at + sizeof(word));
+        std::memcpy(out.data() + at, &word, sizeof(word));
+    }
+};
+
+// reads what UnitBitWriter wrote; reading past the end gives zeros and sets overrun
+class UnitBitReader {
+public:
+    UnitBitReader(const std::byte* first, const std::byte* last) : next{first}, last{last} {}
+
+    // n bits, 1 <= n <= 64
+    std::uint64_t get(int n) {
+        if (n <= available) {
+            const std::uint64_t bits = window >> (64 - n);
+            window = n == 64 ? 0 : window << n;
+            available -= n;
+            return bits;
+        }
+        const int low = n - available;
+        const std::uint64_t high = available == 0 ? 0 : window >> (64 - available);
+        refill();
+        const std::uint64_t bits = window >> (64 - low);
+        window = low == 64 ? 0 : window << low;
+        available = 64 - low;
+        return low == 64 ? bits : high << low | bits;
+    }
+
+    bool bit() {
+        return get(1) != 0;
+    }
+
+    bool overrun() const {
+        return past_end;
+    }
+
+private:
+    const std::byte* next;
+    const std::byte* last;
+    std::uint64_t window = 0;
+    int available = 0;
+    bool past_end = false;
+
+    void refill() {
+        if (last - next >= static_cast<std::ptrdiff_t>(sizeof(window))) {
+            std::memcpy(&window, next, sizeof(window));
+            next += sizeof(window);
+        } else {
+            window = 0;
+            past_end = true;
+        }
+    }
+};
+
+// everything a block header says about a unit type, the sample count and encoding aside
+template<ValueLayoutUnit U>
+constexpr UnitBlockHeader unit_block_header() {
+    UnitBlockHeader header{};
+    std::copy(std::begin(unit_block_magic), std::end(unit_block_magic), header.magic);
+    header.byte_order = 0x01020304;
+    describe_unit_storage<U>(header);
+    return header;
+}
+
+// the header of the block at the front of blocks, FORMAT when it is not one this machine can read
+inline UnitCodecError read_unit_block_header(std::span<const std::byte> blocks, UnitBlockHeader& header) {
+    if (blocks.size() < sizeof(header)) {
+        return UnitCodecError::FORMAT;
+    }
+    std::memcpy(&header, blocks.data(), sizeof(header));
+    const bool valid = std::equal(std::begin(unit_block_magic), std::end(unit_block_magic), header.magic)
+            && header.byte_order == 0x01020304 && static_cast<int>(header.encoding) <= static_cast<int>(UnitCodecEncoding::RAW)
+            && static_cast<int>(header.numeric) <= static_cast<int>(UnitNumericKind::UINT64) && header.num > 0
+            && header.den > 0 && header.offset_den > 0 && header.payload % 8 == 0
+            && header.payload <= blocks.size() - sizeof(header);
+    return valid ? UnitCodecError::NONE : UnitCodecError::FORMAT;
+}
+
+// zigzag, so small negative deltas of deltas are small too
+constexpr std::uint64_t zigzag_encode(std::uint64_t v) {
+    return v << 1 ^ (0 - (v >> 63));
+}
+
+constexpr std::uint64_t zigzag_decode(std::uint64_t v) {
+    return v >> 1 ^ (0 - (v & 1));
+}
+
+// Gorilla's value coding: '0' for a repeat, '10' and the XOR's meaningful bits when they fit the previous window of
+// leading and trailing zeros, otherwise '11', 5 bits of leading zeros, 6 of length and the bits
+template<typename T>
+void encode_xor_values(const T* values, std::size_t n, UnitBitWriter& w) {
+    using bits_t = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+    constexpr int width = sizeof(T) * 8;
+    bits_t previous = std::bit_cast<bits_t>(values[0]);
+    w.put(previous, width);
+    int window_leading = width;
+    int window_trailing = 0;
+    for (std::size_t i = 1; i < n; i++) {
+        const bits_t current = std::bit_cast<bits_t>(values[i]);
+        const bits_t x = current ^ previous;
+        previous = current;
+        if (x == 0) {
+            w.put(0, 1);
+            continue;
+        }
+        const int leading = std::min(std::countl_zero(x), 31);
+        const int trailing = std::countr_zero(x);
+        if (leading >= window_leading && trailing >= window_trailing) {
+            w.put(0b10, 2);
+            w.put(x >> window_trailing, width - window_leading - window_trailing);
+        } else {
+            const int length = width - leading - trailing;
+            w.put(0b11, 2);
+            w.put(leading, 5);
+            w.put(length == 64 ? 0 : length, 6);
+            w.put(x >> trailing, length);
+            window_leading = leading;
+            window_trailing = trailing;
+        }
+    }
+}
+
+// store(i, T) for each of n samples, false when the stream is malformed
+template<typename T, typename Store>
+bool decode_xor_values(UnitBitReader& r, std::size_t n, Store store) {
+    using bits_t = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+    constexpr int width = sizeof(T) * 8;
+    bits_t previous = static_cast<bits_t>(r.get(width));
+    store(0, std::bit_cast<T>(previous));
+    int window_length = 0;
+    int window_trailing = 0;
+    for (std::size_t i = 1; i < n; i++) {
+        if (r.bit()) {
+            if (r.bit()) {
+                const int leading = static_cast<int>(r.get(5));
+                const int length = static_cast<int>(r.get(6));
+                window_length = length == 0 ? 64 : length;
+                window_trailing = width - leading - window_length;
+                if (window_trailing < 0) {
+                    return false;
+                }
+            } else if (window_length == 0) {
+                return false;
+            }
+            previous ^= static_cast<bits_t>(r.get(window_length) << window_trailing);
+        }
+        store(i, std::bit_cast<T>(previous));
+    }
+    return true;
+}
+
+// the first sample in full, then each delta's change from the last delta, zigzagged, behind a prefix choosing 0, 7,
+// 9, 12, 32 or 64 bits
+inline void encode_delta_of_delta(const std::uint64_t* values, std::size_t n, UnitBitWriter& w) {
+    constexpr int widths[] = {7, 9, 12, 32};
+    w.put(values[0], 64);
+    std::uint64_t delta = 0;
+    for (std::size_t i = 1; i < n; i++) {
+        const std::uint64_t next = values[i] - values[i - 1];
+        const std::uint64_t z = zigzag_encode(next - delta);
+        delta = next;
+        if (z == 0) {
+            w.put(0, 1);
+            continue;
+        }
+        int bucket = 0;
+        while (bucket < 4 && z >> widths[bucket] != 0) {
+            bucket++;
+        }
+        // bucket + 1 ones, then a zero unless it is the last bucket
+        w.put(bucket < 4 ? (std::uint64_t{1} << (bucket + 2)) - 2 : 0b11111, bucket < 4 ? bucket + 2 : 5);
+        w.put(z, bucket < 4 ? widths[bucket] : 64);
+    }
+}
+
+template<typename Store>
+bool decode_delta_of_delta(UnitBitReader& r, std::size_t n, Store store) {
+    constexpr int widths[] = {7, 9, 12, 32, 64};
+    std::uint64_t value = r.get(64);
+    store(0, value);
+    std::uint64_t delta = 0;
+    for (std::size_t i = 1; i < n; i++) {
+        if (r.bit()) {
+            int bucket = 0;
+            while (bucket < 4 && r.bit()) {
+                bucket++;
+            }
+            delta += zigzag_decode(r.get(widths[bucket]));
+        }
+        value += delta;
+        store(i, value);
+    }
+    return true;
+}
+
+// floating-point samples that are all whole numbers small enough to be exact in an int64_t, with no -0.0
+template<typename T>
+bool whole_number_values(const T* values, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) {
+        if (!(std::trunc(values[i]) == values[i] && std::abs(values[i]) <= 0x1.0p53) || (values[i] == 0 && std::signbit(values[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// appends one block holding every value, at most 2^32 - 1 of them
+template<ValueLayoutUnit U>
+void encode_units(std::span<const U> values, std::vector<std::byte>& out) {
+    using value_t = decltype(U::value);
+    assert(values.size() <= std::numeric_limits<std::uint32_t>::max() && "Too many samples for one unit block");
+    UnitBlockHeader header = unit_block_header<U>();
+    header.count = static_cast<std::uint32_t>(values.size());
+    const std::size_t at = out.size();
+    out.resize(at + sizeof(header));
+    if (!values.empty()) {
+        const value_t* v = &values.data()->value;
+        UnitBitWriter w{out};
+        std::vector<std::uint64_t> whole;
+        if constexpr (std::is_floating_point_v<value_t>) {
+            if (whole_number_values(v, values.size())) {
+                whole.resize(values.size());
+                std::transform(v, v + values.size(), whole.begin(), [](value_t x) {
+                    return static_cast<std::uint64_t>(static_cast<std::int64_t>(x));
+                });
+            } else {
+                header.encoding = UnitCodecEncoding::XOR;
+                encode_xor_values(v, values.size(), w);
+            }
+        } else {
+            whole.resize(values.size());
+            std::transform(v, v + values.size(), whole.begin(), [](value_t x) {
+                if constexpr (FixedPointType<value_t>) {
+                    return static_cast<std::uint64_t>(static_cast<std::int64_t>(x.raw));
+                } else if constexpr (std::is_signed_v<value_t>) {
+                    return static_cast<std::uint64_t>(static_cast<std::int64_t>(x));
+                } else {
+                    return static_cast<std::uint64_t>(x);
+                }
+            });
+        }
+        if (!whole.empty()) {
+            header.encoding = UnitCodecEncoding::DELTA_OF_DELTA;
+            encode_delta_of_delta(whole.data(), whole.size(), w);
+        }
+        w.finish();
+        // noise does not compress, and is kept raw rather than grown
+        const std::size_t raw = (values.size() * sizeof(value_t) + 7) / 8 * 8;
+        if (out.size() - at - sizeof(header) > raw) {
+            header.encoding = UnitCodecEncoding::RAW;
+            out.resize(at + sizeof(header));
+            out.resize(at + sizeof(header) + raw);
+            std::memcpy(out.data() + at + sizeof(header), values.data(), values.size() * sizeof(value_t));
+        }
+    }
+    header.payload = out.size() - at - sizeof(header);
+    std::memcpy(out.data() + at, &header, sizeof(header));
+}
+
+// a std::vector<Volt> or any other contiguous range of units
+template<std::ranges::contiguous_range R>
+requires ValueLayoutUnit<std::ranges::range_value_t<R>>
+void encode_units(const R& values, std::vector<std::byte>& out) {
+    encode_units(std::span<const std::ranges::range_value_t<R>>{std::ranges::data(values), std::ranges::size(values)}, out);
+}
+
+// the block at the front of blocks into the front of out as U, converted from the stored unit sample by sample; a
+// block of another dimension is DIMENSION_MISMATCH, and one of more samples than out holds is OUTPUT_TOO_SMALL
+template<ValueLayoutUnit U>
+UnitDecodeResult decode_units(std::span<const std::byte> blocks, std::span<U> out) {
+    using value_t = decltype(U::value);
+    UnitDecodeResult result;
+    UnitBlockHeader header;
+    result.error = read_unit_block_header(blocks, header);
+    const UnitBlockHeader wanted = unit_block_header<U>();
+    if (result.error == UnitCodecError::NONE && header.dimension != wanted.dimension) {
+        result.error = UnitCodecError::DIMENSION_MISMATCH;
+    } else if (result.error == UnitCodecError::NONE && header.count > out.size()) {
+        result.error = UnitCodecError::OUTPUT_TOO_SMALL;
+    }
+    if (result.error != UnitCodecError::NONE) {
+        return result;
+    }
+    const bool exact = header.numeric == wanted.numeric && header.fixed == wanted.fixed && header.fractional_bits == wanted.fractional_bits
+            && header.num == wanted.num && header.den == wanted.den && header.offset_num == wanted.offset_num
+            && header.offset_den == wanted.offset_den;
+    // (v + offset) * num / den base units, then back out through U's ratio and offset, folded into one multiply-add
+    const double ratio = rounded_quotient(wide_uintmax_t(header.num) * wanted.den, wide_uintmax_t(header.den) * wanted.num);
+    const double scale = ratio * (header.fixed ? std::ldexp(1.0, -header.fractional_bits) : 1.0);
+    const double shift = static_cast<double>(header.offset_num) / header.offset_den * ratio
+            - static_cast<double>(wanted.offset_num) / wanted.offset_den;
+    auto converted = [&](double v) {
+        return U{unit_numeric_from_double<value_t>(v * scale + shift)};
+    };
+    const std::byte* payload = blocks.data() + sizeof(header);
+    UnitBitReader r{payload, payload + header.payload};
+    bool valid = true;
+    if (header.count != 0 && header.encoding == UnitCodecEncoding::XOR) {
+        auto decode = [&]<typename T>() {
+            if (exact) {
+                if constexpr (std::is_same_v<T, value_t>) {
+                    return decode_xor_values<T>(r, header.count, [&](std::size_t i, T v) {
+                        out[i] = U{v};
+                    });
+                }
+            }
+            return decode_xor_values<T>(r, header.count, [&](std::size_t i, T v) {
+                out[i] = converted(static_cast<double>(v));
+            });
+        };
+        if (header.numeric == UnitNumericKind::FLOAT32) {
+            valid = decode.template operator()<float>();
+        } else {
+            valid = header.numeric == UnitNumericKind::FLOAT64 && decode.template operator()<double>();
+        }
+    } else if (header.count != 0 && header.encoding == UnitCodecEncoding::RAW) {
+        valid = header.payload >= header.count * unit_numeric_size(header.numeric);
+        if (valid && exact) {
+            std::memcpy(out.data(), payload, header.count * sizeof(value_t));
+        } else if (valid) {
+            auto decode = [&]<typename T>() {
+                for (std::size_t i = 0; i < header.count; i++) {
+                    T v;
+                    std::memcpy(&v, payload + i * sizeof(T), sizeof(T));
+                    out[i] = converted(static_cast<double>(v));
+                }
+            };
+            visit_unit_numeric(header.numeric, decode);
+        }
+    } else if (header.count != 0) {
+        // whole-number floating-point samples were coded as int64_t
+        const bool signed_values = header.numeric <= UnitNumericKind::INT64;
+        if (exact && !std::is_floating_point_v<value_t>) {
+            valid = decode_delta_of_delta(r, header.count, [&](std::size_t i, std::uint64_t v) {
+                if constexpr (FixedPointType<value_t>) {
+                    out[i] = U{value_t::from_raw(static_cast<typename value_t::rep>(v))};
+                } else if constexpr (std::is_integral_v<value_t>) {
+                    out[i] = U{static_cast<value_t>(v)};
+                }
+            });
+        } else if (signed_values) {
+            valid = decode_delta_of_delta(r, header.count, [&](std::size_t i, std::uint64_t v) {
+                out[i] = converted(static_cast<double>(static_cast<std::int64_t>(v)));
+            });
+        } else {
+            valid = decode_delta_of_delta(r, header.count, [&](std::size_t i, std::uint64_t v) {
+                out[i] = converted(static_cast<double>(v));
+            });
+        }
+    }
+    if (!valid || r.overrun()) {
+        result.error = UnitCodecError::FORMAT;
+        return result;
+    }
+    result.values = header.count;
+    result.consumed = sizeof(header) + header.payload;
+    return result;
+}
+
+#endif //UNITMAKER_UNIT_CODEC_H
@@ -0,0 +1,355 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_UNIT_COLUMNS_H
+#define UNITMAKER_UNIT_COLUMNS_H
+
+#include "mapped_file.h"
+#include "unit_convert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// A binary file of unit columns: a header recording every column's dimension, ratio, offset and numeric type, then
+// the raw values of each column aligned to unit_column_alignment. A column read back as the unit it was written as is
+// a span straight into the mapped file; read as another unit of the same dimension it is a view converting values as
+// they are read, or in bulk through copy_to. Files are written and read in the byte order of the machine, which is
+// recorded and checked.
+
+inline constexpr std::size_t unit_column_alignment = 64;
+inline constexpr std::size_t unit_column_name_length = 64;
+
+enum class UnitColumnError {
+    NONE, OPEN, WRITE, FORMAT, MISSING_COLUMN, DIMENSION_MISMATCH
+};
+
+struct UnitFileHeader {
+    char magic[8];
+    std::uint32_t version;
+    // 0x01020304 as the writer stored it
+    std::uint32_t byte_order;
+    std::uint64_t columns;
+    std::uint64_t reserved;
+};
+
+struct UnitColumnHeader {
+    char name[unit_column_name_length];
+    dimension_t dimension;
+    std::int64_t num;
+    std::int64_t den;
+    std::int64_t offset_num;
+    std::int64_t offset_den;
+    std::uint64_t rows;
+    // from the start of the file, a multiple of unit_column_alignment
+    std::uint64_t payload;
+    UnitNumericKind numeric;
+    std::uint8_t fixed;
+    std::uint8_t fractional_bits;
+    std::uint8_t reserved[5];
+
+    std::string_view column_name() const {
+        return {name, static_cast<std::size_t>(std::find(name, name + unit_column_name_length, '\0') - name)};
+    }
+
+    std::size_t payload_bytes() const {
+        return rows * unit_numeric_size(numeric);
+    }
+};
+
+static_assert(sizeof(UnitFileHeader) == 32 && sizeof(UnitColumnHeader) == 128 && std::is_trivially_copyable_v<UnitColumnHeader>);
+
+inline constexpr char unit_file_magic[8] = {'U', 'N', 'I', 'T', 'C', 'O', 'L', 'S'};
+inline constexpr std::uint32_t unit_file_version = 1;
+
+// everything a column header says about a unit type, the name and placement aside
+template<ValueLayoutUnit U>
+constexpr UnitColumnHeader unit_column_header() {
+    UnitColumnHeader header{};
+    describe_unit_storage<U>(header);
+    return header;
+}
+
+// collects columns, which are not copied and must outlive write
+class UnitColumnWriter {
+public:
+    template<ValueLayoutUnit U>
+    void add(std::string_view name, std::span<const U> values) {
+        assert(name.size() <= unit_column_name_length && "Unit column name too long");
+        UnitColumnHeader header = unit_column_header<U>();
+        std::copy(name.begin(), name.end(), header.name);
+        header.rows = values.size();
+        columns.push_back({header, reinterpret_cast<const std::byte*>(values.data())});
+    }
+
+    // a std::vector<Meter> or any other contiguous range of units
+    template<std::ranges::contiguous_range R>
+    requires ValueLayoutUnit<std::ranges::range_value_t<R>>
+    void add(std::string_view name, const R& values) {
+        add(name, std::span<const std::ranges::range_value_t<R>>{std::ranges::data(values), std::ranges::size(values)});
+    }
+
+    UnitColumnError write(const char* path) const {
+        std::FILE* f = std::fopen(path, "wb");
+        if (f == nullptr) {
+            return UnitColumnError::OPEN;
+        }
+        UnitFileHeader file{};
+        std::copy(std::begin(unit_file_magic), std::end(unit_file_magic), file.magic);
+        file.version = unit_file_version;
+        file.byte_order = 0x01020304;
+        file.columns = columns.size();
+        std::vector<UnitColumnHeader> headers;
+        std::uint64_t payload = aligned(sizeof(UnitFileHeader) + columns.size() * sizeof(UnitColumnHeader));
+        for (const Column& c : columns) {
+            headers.push_back(c.header);
+            headers.back().payload = payload;
+            payload = aligned(payload + c.header.payload_bytes());
+        }
+        bool written = std::fwrite(&file, sizeof(file), 1, f) == 1
+                && std::fwrite(headers.data(), sizeof(UnitColumnHeader), headers.size(), f) == headers.size();
+        std::uint64_t at = sizeof(UnitFileHeader) + headers.size() * sizeof(UnitColumnHeader);
+        constexpr std::byte padding[unit_column_alignment]{};
+        for (std::size_t i = 0; i < columns.size() && written; i++) {
+            const std::size_t bytes = headers[i].payload_bytes();
+            written = std::fwrite(padding, 1, headers[i].payload - at, f) == headers[i].payload - at
+                    && std::fwrite(columns[i].data, 1, bytes, f) == bytes;
+            at = headers[i].payload + bytes;
+        }
+        written = std::fclose(f) == 0 && written;
+        return written ? UnitColumnError::NONE : UnitColumnError::WRITE;
+    }
+
+private:
+    struct Column {
+        UnitColumnHeader header;
+        const std::byte* data;
+    };
+
+    std::vector<Column> columns;
+
+    static std::uint64_t aligned(std::uint64_t offset) {
+        return (offset + unit_column_alignment - 1) / unit_column_alignment * unit_column_alignment;
+    }
+};
+
+template<typename T>
+double load_stored_value(const std::byte* p, double fixed_scale) {
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    return static_cast<double>(v) * fixed_scale;
+}
+
+// a column read as U: a span into the file when it was stored as U, otherwise converted one value at a time
+template<ValueLayoutUnit U>
+class UnitColumnView {
+public:
+    using value_type = U;
+    using numeric_t = decltype(U::value);
+
+    class iterator {
+    public:
+        using value_type = U;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        iterator(const UnitColumnView* view, std::size_t i) : view{view}, i{i} {}
+
+        U operator*() const {
+            return (*view)[i];
+        }
+
+        iterator& operator++() {
+            i++;
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator before = *this;
+            i++;
+            return before;
+        }
+
+        friend bool operator==(const iterator& a, const iterator& b) {
+            return a.i == b.i;
+        }
+
+    private:
+        const UnitColumnView* view = nullptr;
+        std::size_t i = 0;
+    };
+
+    UnitColumnView() = default;
+
+    UnitColumnView(UnitColumnError error) : status{error} {}
+
+    UnitColumnView(const UnitColumnHeader& header, const std::byte* data) : data{data}, rows{header.rows},
+            kind{header.numeric} {
+        const UnitColumnHeader wanted = unit_column_header<U>();
+        exact = header.numeric == wanted.numeric && header.fixed == wanted.fixed && header.fractional_bits == wanted.fractional_bits
+                && header.num == wanted.num && header.den == wanted.den && header.offset_num == wanted.offset_num
+                && header.offset_den == wanted.offset_den;
+        // (v + offset) * num / den base units, then back out through U's ratio and offset
+        scale = rounded_quotient(wide_uintmax_t(header.num) * wanted.den, wide_uintmax_t(header.den) * wanted.num);
+        shift = static_cast<double>(header.offset_num) / header.offset_den * scale
+                - static_cast<double>(wanted.offset_num) / wanted.offset_den;
+        fixed_scale = header.fixed ? std::ldexp(1.0, -header.fractional_bits) : 1.0;
+    }
+
+    UnitColumnError error() const {
+        return status;
+    }
+
+    explicit operator bool() const {
+        return status == UnitColumnError::NONE;
+    }
+
+    // stored as U, so span() needs no conversion
+    bool direct() const {
+        return exact;
+    }
+
+    // the values in place, only when direct()
+    std::span<const U> span() const {
+        assert(exact && "Unit column is stored as another unit, read it through operator[] or copy_to");
+        return {std::launder(reinterpret_cast<const U*>(data)), rows};
+    }
+
+    std::size_t size() const {
+        return rows;
+    }
+
+    U operator[](std::size_t i) const {
+        if (exact) {
+            return span()[i];
+        }
+        return U{unit_numeric_from_double<numeric_t>(load(data + i * unit_numeric_size(kind)) * scale + shift)};
+    }
+
+    iterator begin() const {
+        return {this, 0};
+    }
+
+    iterator end() const {
+        return {this, rows};
+    }
+
+    // values [first, first + out.size()) into out, converted in one pass per column
+    void copy_to(std::span<U> out, std::size_t first = 0) const {
+        assert(first + out.size() <= rows && "Unit column copy past its end");
+        if (exact) {
+            std::copy_n(span().begin() + first, out.size(), out.begin());
+            return;
+        }
+        auto loop = [&]<typename T>() {
+            const std::byte* p = data + first * sizeof(T);
+            if constexpr (std::is_same_v<T, numeric_t> && array_kernel_type<T>) {
+                // the factor stays in double so that every value is rounded once, as operator[] rounds it
+                array_affine(reinterpret_cast<const T*>(p), scale * fixed_scale, shift, &out.data()->value, out.size());
+            } else {
+                for (std::size_t i = 0; i < out.size(); i++) {
+                    const double v = load_stored_value<T>(p + i * sizeof(T), fixed_scale);
+                    out[i] = U{unit_numeric_from_double<numeric_t>(v * scale + shift)};
+                }
+            }
+        };
+        visit_unit_numeric(kind, loop);
+    }
+
+private:
+    const std::byte* data = nullptr;
+    std::size_t rows = 0;
+    UnitNumericKind kind = UnitNumericKind::FLOAT64;
+    UnitColumnError status = UnitColumnError::NONE;
+    bool exact = false;
+    double scale = 1.0;
+    double shift = 0.0;
+    double fixed_scale = 1.0;
+
+    double load(const std::byte* p) const {
+        return visit_unit_numeric(kind, [&]<typename T>() {
+            return load_stored_value<T>(p, fixed_scale);
+        });
+    }
+};
+
+// a mapped column file, checked when it is opened
+class UnitColumnFile {
+public:
+    explicit UnitColumnFile(const char* path) : file{path} {
+        if (!file) {
+            status = UnitColumnError::OPEN;
+            return;
+        }
+        const std::string_view text = file.text();
+        UnitFileHeader header;
+        if (text.size() < sizeof(header)) {
+            status = UnitColumnError::FORMAT;
+            return;
+        }
+        std::memcpy(&header, text.data(), sizeof(header));
+        if (!std::equal(std::begin(unit_file_magic), std::end(unit_file_magic), header.magic)
+                || header.version != unit_file_version || header.byte_order != 0x01020304
+                || header.columns > (text.size() - sizeof(header)) / sizeof(UnitColumnHeader)) {
+            status = UnitColumnError::FORMAT;
+            return;
+        }
+        headers.resize(header.columns);
+        std::memcpy(headers.data(), text.data() + sizeof(header), headers.size() * sizeof(UnitColumnHeader));
+        for (const UnitColumnHeader& c : headers) {
+            if (static_cast<int>(c.numeric) > static_cast<int>(UnitNumericKind::UINT64) || c.num <= 0 || c.den <= 0
+                    || c.offset_den <= 0 || c.payload % unit_column_alignment != 0 || c.payload > text.size()
+                    || c.rows > (text.size() - c.payload) / unit_numeric_size(c.numeric)) {
+                status = UnitColumnError::FORMAT;
+                return;
+            }
+        }
+    }
+
+    UnitColumnError error() const {
+        return status;
+    }
+
+    explicit operator bool() const {
+        return status == UnitColumnError::NONE;
+    }
+
+    std::span<const UnitColumnHeader> columns() const {
+        return headers;
+    }
+
+    // the column called name read as U, MISSING_COLUMN or DIMENSION_MISMATCH otherwise
+    template<ValueLayoutUnit U>
+    UnitColumnView<U> column(std::string_view name) const {
+        if (status != UnitColumnError::NONE) {
+            return {status};
+        }
+        for (const UnitColumnHeader& c : headers) {
+            if (c.column_name() == name) {
+                if (c.dimension != unit_column_header<U>().dimension) {
+                    return {UnitColumnError::DIMENSION_MISMATCH};
+                }
+                return {c, reinterpret_cast<const std::byte*>(file.text().data()) + c.payload};
+            }
+        }
+        return {UnitColumnError::MISSING_COLUMN};
+    }
+
+private:
+    MappedFile file;
+    std::vector<UnitColumnHeader> headers;
+    UnitColumnError status = UnitColumnError::NONE;
+};
+
+#endif //UNITMAKER_UNIT_COLUMNS_H
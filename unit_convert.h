@@ -0,0 +1,184 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_UNIT_CONVERT_H
+#define UNITMAKER_UNIT_CONVERT_H
+
+#include "units.h"
+#include "unit_kernels.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ranges>
+#include <span>
+#include <type_traits>
+
+// convert_n converts whole buffers of units with the same factors and rounding as the implicit conversion of a single
+// unit, through the dispatched kernels of unit_kernels.h when both sides hold float or double.
+
+// a unit is stored as nothing but its value, so a buffer of units can be walked as a buffer of values
+template<typename U>
+concept ValueLayoutUnit = (UnitType<U> || UnitOffsetType<U>) && sizeof(U) == sizeof(decltype(U::value))
+        && std::is_trivially_copyable_v<U>;
+
+// how unit files and blocks store values, fixed-point values as their raw integers
+enum class UnitNumericKind : std::uint8_t {
+    FLOAT32, FLOAT64, INT8, INT16, INT32, INT64, UINT8, UINT16, UINT32, UINT64
+};
+
+template<typename T>
+constexpr UnitNumericKind unit_numeric_kind() {
+    if constexpr (FixedPointType<T>) {
+        return unit_numeric_kind<typename T::rep>();
+    } else if constexpr (std::is_floating_point_v<T>) {
+        static_assert(sizeof(T) == 4 || sizeof(T) == 8, "Units are stored as 32 or 64-bit floating point");
+        return sizeof(T) == 4 ? UnitNumericKind::FLOAT32 : UnitNumericKind::FLOAT64;
+    } else {
+        constexpr int width = std::countr_zero(sizeof(T));
+        return static_cast<UnitNumericKind>((std::is_signed_v<T> ? 2 : 6) + width);
+    }
+}
+
+constexpr std::size_t unit_numeric_size(UnitNumericKind kind) {
+    constexpr std::size_t sizes[] = {4, 8, 1, 2, 4, 8, 1, 2, 4, 8};
+    return sizes[static_cast<int>(kind)];
+}
+
+// f.template operator()<T>() for the type values of kind are stored as
+template<typename F>
+decltype(auto) visit_unit_numeric(UnitNumericKind kind, F&& f) {
+    switch (kind) {
+        case UnitNumericKind::FLOAT32: return f.template operator()<float>();
+        case UnitNumericKind::INT8: return f.template operator()<std::int8_t>();
+        case UnitNumericKind::INT16: return f.template operator()<std::int16_t>();
+        case UnitNumericKind::INT32: return f.template operator()<std::int32_t>();
+        case UnitNumericKind::INT64: return f.template operator()<std::int64_t>();
+        case UnitNumericKind::UINT8: return f.template operator()<std::uint8_t>();
+        case UnitNumericKind::UINT16: return f.template operator()<std::uint16_t>();
+        case UnitNumericKind::UINT32: return f.template operator()<std::uint32_t>();
+        case UnitNumericKind::UINT64: return f.template operator()<std::uint64_t>();
+        case UnitNumericKind::FLOAT64: break;
+    }
+    return f.template operator()<double>();
+}
+
+// a converted value back in a unit's numeric type, integers rounded to the nearest
+template<typename T>
+T unit_numeric_from_double(double v) {
+    if constexpr (std::is_integral_v<T>) {
+        return static_cast<T>(std::llround(v));
+    } else {
+        return static_cast<T>(v);
+    }
+}
+
+// the dimension, ratio, offset and numeric fields that unit file and block headers share, filled in for U
+template<ValueLayoutUnit U, typename Header>
+constexpr void describe_unit_storage(Header& header) {
+    using value_t = decltype(U::value);
+    if constexpr (UnitOffsetType<U>) {
+        using unit_t = typename UnitOffsetTraits<U>::unit_type;
+        header.dimension = unit_t::base_type::packed;
+        header.num = unit_t::ratio::num;
+        header.den = unit_t::ratio::den;
+        header.offset_num = UnitOffsetTraits<U>::offset::num;
+        header.offset_den = UnitOffsetTraits<U>::offset::den;
+    } else {
+        header.dimension = U::base_type::packed;
+        header.num = U::ratio::num;
+        header.den = U::ratio::den;
+        header.offset_num = 0;
+        header.offset_den = 1;
+    }
+    header.numeric = unit_numeric_kind<value_t>();
+    if constexpr (FixedPointType<value_t>) {
+        header.fixed = 1;
+        header.fractional_bits = value_t::fractional_bits;
+    }
+}
+
+template<UnitType From, UnitType To>
+requires EquivalentBaseType<From, To>
+void convert_values(const decltype(From::value)* in, decltype(To::value)* out, std::size_t n) {
+    using from_t = decltype(From::value);
+    using to_t = decltype(To::value);
+    using factor_t = ConversionFactor<typename From::ratio, typename To::ratio>;
+    if constexpr (std::is_same_v<from_t, to_t> && factor_t::num == 1 && factor_t::den == 1) {
+        if (in != out) {
+            std::copy_n(in, n, out);
+        }
+    } else if constexpr (std::is_same_v<from_t, to_t> && array_kernel_type<to_t>) {
+        array_scale(in, factor_t::value, out, n);
+    } else {
+        UNITMAKER_IVDEP
+        for (std::size_t i = 0; i < n; i++) {
+            out[i] = scale_value<factor_t, to_t>(in[i]);
+        }
+    }
+}
+
+// out may be the same buffer as in, but must not partially overlap it
+template<UnitType From, UnitType To>
+requires EquivalentBaseType<From, To> && ValueLayoutUnit<From> && ValueLayoutUnit<To>
+void convert_n(const From* in, std::size_t n, To* out) {
+    if (n != 0) {
+        convert_values<From, To>(&in->value, &out->value, n);
+    }
+}
+
+// (value + offset) * k, rounded after the offset and after k like the conversion of a single UnitOffset
+template<UnitOffsetType From, UnitType To>
+requires EquivalentBaseType<typename UnitOffsetTraits<From>::unit_type, To> && ValueLayoutUnit<From> && ValueLayoutUnit<To>
+void convert_n(const From* in, std::size_t n, To* out) {
+    using unit_t = typename UnitOffsetTraits<From>::unit_type;
+    using offset_t = typename UnitOffsetTraits<From>::offset;
+    using to_t = decltype(To::value);
+    if (n == 0) {
+        return;
+    }
+    if constexpr (std::is_same_v<decltype(From::value), to_t> && array_kernel_type<to_t> && std::is_same_v<decltype(unit_t::value), to_t>) {
+        constexpr double k = ConversionFactor<typename unit_t::ratio, typename To::ratio>::value;
+        constexpr double offset = 1.0 * offset_t::num / offset_t::den;
+        array_offset_scale(&in->value, offset, k, &out->value, n);
+    } else {
+        for (std::size_t i = 0; i < n; i++) {
+            out[i] = static_cast<To>(in[i]);
+        }
+    }
+}
+
+template<typename From, typename To>
+requires requires(const From* in, To* out) { convert_n(in, std::size_t{}, out); }
+void convert_n(std::span<const From> in, std::span<To> out) {
+    assert(out.size() >= in.size() && "convert_n output is shorter than its input");
+    convert_n(in.data(), in.size(), out.data());
+}
+
+// any pair of contiguous ranges, such as std::vector<Pound> and std::array<Newton, N>
+template<std::ranges::contiguous_range In, std::ranges::contiguous_range Out>
+requires requires(In&& in, Out&& out) { convert_n(std::ranges::data(in), std::size_t{}, std::ranges::data(out)); }
+void convert_n(In&& in, Out&& out) {
+    assert(std::ranges::size(out) >= std::ranges::size(in) && "convert_n output is shorter than its input");
+    convert_n(std::ranges::data(in), std::ranges::size(in), std::ranges::data(out));
+}
+
+// reuses the storage of units for the converted values, the returned span aliases it
+template<UnitType To, typename From>
+requires requires(const From* in, To* out) { convert_n(in, std::size_t{}, out); }
+std::span<To> convert_in_place(std::span<From> units) {
+    static_assert(sizeof(From) == sizeof(To) && alignof(From) % alignof(To) == 0,
+            "convert_in_place requires units of the same size and alignment");
+    void* storage = units.data();
+    convert_n(units.data(), units.size(), static_cast<To*>(storage));
+    // copying the storage onto itself implicitly creates the To objects the converted values belong to, which writing
+    // their values alone does not; memmove returns a pointer to them
+    To* out = static_cast<To*>(std::memmove(storage, storage, units.size_bytes()));
+    return {out, units.size()};
+}
+
+#endif //UNITMAKER_UNIT_CONVERT_H
@@ -0,0 +1,326 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_UNIT_CSV_H
+#define UNITMAKER_UNIT_CSV_H
+
+#include "mapped_file.h"
+#include "unit_scan.h"
+
+#include <algorithm>
+#include <array>
+#include <barrier>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// CSV files whose header names carry units, eg. "time[s],pressure[psi],temp[°F]", read into columns of chosen unit
+// types. Each requested column's header unit is checked against its target once when the file is opened, the cells
+// are converted while they are parsed, and rows arrive a fixed number at a time in buffers that are reused, with the
+// pages behind them handed back to the system, so memory stays flat however large the file. Quoted fields may hold
+// commas but not line breaks, which is what lets the file be split between threads at any line.
+
+enum class UnitCsvError {
+    NONE, OPEN, NO_HEADER, MISSING_COLUMN, UNKNOWN_UNIT, DIMENSION_MISMATCH
+};
+
+// the '\n' in [first, last)
+inline std::size_t count_line_breaks(const char* first, const char* last) {
+    constexpr std::size_t batch = 64;
+    std::uint64_t masks[batch];
+    std::size_t count = 0;
+    while (last - first >= 64) {
+        const std::size_t blocks = std::min<std::size_t>(batch, (last - first) / 64);
+        line_break_masks(first, blocks, masks);
+        for (std::size_t b = 0; b < blocks; b++) {
+            count += std::popcount(masks[b]);
+        }
+        first += 64 * blocks;
+    }
+    return count + std::count(first, last, '\n');
+}
+
+template<typename... Targets>
+struct UnitCsvChunk {
+    // counted from 0 after the header, a blank line is a row of invalid cells
+    std::size_t first_row = 0;
+    std::size_t rows = 0;
+    // cells that were missing or not a number, NaN in floating-point columns and 0 in the others
+    std::size_t invalid = 0;
+    std::tuple<std::vector<Targets>...> buffers;
+
+    explicit UnitCsvChunk(std::size_t capacity) : buffers{std::vector<Targets>(capacity, Targets{0})...} {}
+
+    template<std::size_t I>
+    std::span<const std::tuple_element_t<I, std::tuple<Targets...>>> column() const {
+        return {std::get<I>(buffers).data(), rows};
+    }
+};
+
+// reads the columns named at construction into Targets, in order, either chunk by chunk through next or all at once
+// across threads through read_parallel
+template<typename... Targets>
+requires ((UnitType<Targets> || UnitOffsetType<Targets>) && ...)
+class UnitCsvReader {
+public:
+    static constexpr std::size_t column_count = sizeof...(Targets);
+    using chunk_type = UnitCsvChunk<Targets...>;
+
+    UnitCsvReader(const char* path, const std::array<std::string_view, column_count>& names, std::size_t chunk_rows = 1 << 16)
+            : file{path}, chunk_rows{chunk_rows}, chunk{chunk_rows} {
+        if (!file) {
+            fail(UnitCsvError::OPEN, 0);
+            return;
+        }
+        open(names);
+    }
+
+    UnitCsvError error() const {
+        return status;
+    }
+
+    // which of the names the error is about, for MISSING_COLUMN, UNKNOWN_UNIT and DIMENSION_MISMATCH
+    std::size_t error_column() const {
+        return failed_column;
+    }
+
+    explicit operator bool() const {
+        return status == UnitCsvError::NONE;
+    }
+
+    // the unit in the header of column i, eg. "psi"
+    std::string_view unit(std::size_t i) const {
+        return units[i];
+    }
+
+    // up to chunk_rows further rows, none once the file is read; the chunk is overwritten by the next call
+    const chunk_type& next() {
+        chunk.first_row = row;
+        const char* start = position;
+        position = parse_rows(position, end(), chunk);
+        row += chunk.rows;
+        file.release(start, position);
+        return chunk;
+    }
+
+    // every remaining row, the file split into one range of whole lines per thread and each parsed chunk by chunk
+    // into its own buffers; on_chunk(const chunk_type&) is called from the threads at once
+    template<typename F>
+    void read_parallel(F on_chunk, unsigned threads = std::max(1u, std::thread::hardware_concurrency())) {
+        threads = std::max(threads, 1u);
+        const char* const begin = position;
+        std::vector<const char*> bounds(threads + 1, end());
+        bounds[0] = begin;
+        for (unsigned i = 1; i < threads; i++) {
+            const char* p = std::max(begin + (end() - begin) / threads * i, bounds[i - 1]);
+            const char* line_break = static_cast<const char*>(std::memchr(p, '\n', end() - p));
+            bounds[i] = line_break == nullptr ? end() : line_break + 1;
+        }
+        // each thread counts the line breaks of its own range, and once all have, the counts are summed into the row
+        // every range starts at
+        std::vector<std::size_t> first_rows(threads + 1, row);
+        std::barrier counted{threads, [&]() noexcept {
+            std::partial_sum(first_rows.begin(), first_rows.end(), first_rows.begin());
+        }};
+        auto work = [&](unsigned i) {
+            first_rows[i + 1] = count_line_breaks(bounds[i], bounds[i + 1]);
+            counted.arrive_and_wait();
+            chunk_type local{chunk_rows};
+            local.first_row = first_rows[i];
+            for (const char* p = bounds[i]; p != bounds[i + 1];) {
+                const char* start = p;
+                p = parse_rows(p, bounds[i + 1], local);
+                on_chunk(std::as_const(local));
+                local.first_row += local.rows;
+                file.release(start, p);
+            }
+        };
+        std::vector<std::thread> pool;
+        for (unsigned i = 1; i < threads; i++) {
+            pool.emplace_back(work, i);
+        }
+        work(0);
+        for (std::thread& t : pool) {
+            t.join();
+        }
+        row = first_rows[threads] + (begin != end() && end()[-1] != '\n');
+        position = end();
+    }
+
+private:
+    MappedFile file;
+    std::size_t chunk_rows;
+    chunk_type chunk;
+    UnitCsvError status = UnitCsvError::NONE;
+    std::size_t failed_column = 0;
+    const char* position = nullptr;
+    std::size_t row = 0;
+    // for every field of a row the column it is read into, or -1, up to the last field read
+    std::vector<int> field_columns;
+    std::array<std::string_view, column_count> units{};
+    std::array<double, column_count> scales{};
+    std::array<double, column_count> shifts{};
+
+    const char* end() const {
+        return file.text().data() + file.text().size();
+    }
+
+    static std::string_view trim(std::string_view s) {
+        while (!s.empty() && (s.front() == ' ' || s.front() == '\t' || s.front() == '"')) {
+            s.remove_prefix(1);
+        }
+        while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r' || s.back() == '"')) {
+            s.remove_suffix(1);
+        }
+        return s;
+    }
+
+    // [first, the ',' or last ending the field), a quoted field running to its closing quote
+    static const char* skip_field(const char* first, const char* last) {
+        const char* p = first;
+        if (p != last && *p == '"') {
+            for (p++; p != last; p++) {
+                if (*p == '"' && (++p == last || *p != '"')) {
+                    break;
+                }
+            }
+        }
+        const char* comma = static_cast<const char*>(std::memchr(p, ',', last - p));
+        return comma == nullptr ? last : comma;
+    }
+
+    // a reader that failed to open has no rows
+    void fail(UnitCsvError error, std::size_t column) {
+        status = error;
+        failed_column = column;
+        position = end();
+    }
+
+    void open(const std::array<std::string_view, column_count>& names) {
+        std::string_view text = file.text();
+        // a UTF-8 byte order mark
+        if (text.starts_with("\xef\xbb\xbf")) {
+            text.remove_prefix(3);
+        }
+        const std::size_t header_end = std::min(text.find('\n'), text.size());
+        if (trim(text.substr(0, header_end)).empty()) {
+            fail(UnitCsvError::NO_HEADER, 0);
+            return;
+        }
+        position = text.data() + std::min(header_end + 1, text.size());
+        std::array<bool, column_count> found{};
+        const char* const header_last = text.data() + header_end;
+        for (const char* p = text.data();; p++) {
+            const char* field_end = skip_field(p, header_last);
+            // name[unit], a field without brackets is dimensionless
+            const std::string_view field = trim({p, static_cast<std::size_t>(field_end - p)});
+            const std::size_t open_bracket = std::min(field.find('['), field.size());
+            const std::string_view name = trim(field.substr(0, open_bracket));
+            std::string_view unit = field.substr(open_bracket);
+            unit = unit.empty() ? "1" : trim(unit.substr(1, unit.find(']') - 1));
+            int column = -1;
+            for (std::size_t i = 0; i < column_count; i++) {
+                if (!found[i] && names[i] == name) {
+                    column = static_cast<int>(i);
+                    found[i] = true;
+                    units[i] = unit;
+                    break;
+                }
+            }
+            field_columns.push_back(column);
+            if (field_end == header_last) {
+                break;
+            }
+            p = field_end;
+        }
+        for (std::size_t i = 0; i < column_count; i++) {
+            if (!found[i]) {
+                fail(UnitCsvError::MISSING_COLUMN, i);
+                return;
+            }
+        }
+        // the dimension is checked here, once per column
+        const std::array<UnitScanError, column_count> errors = [&]<std::size_t... I>(std::index_sequence<I...>) {
+            return std::array<UnitScanError, column_count>{find_unit_scale<Targets>(units[I], scales[I], shifts[I])...};
+        }(std::index_sequence_for<Targets...>{});
+        for (std::size_t i = 0; i < column_count; i++) {
+            if (errors[i] != UnitScanError::NONE) {
+                fail(errors[i] == UnitScanError::DIMENSION_MISMATCH ? UnitCsvError::DIMENSION_MISMATCH : UnitCsvError::UNKNOWN_UNIT, i);
+                return;
+            }
+        }
+        while (field_columns.back() < 0) {
+            field_columns.pop_back();
+        }
+    }
+
+    template<std::size_t I>
+    void store(chunk_type& c, std::size_t r, double v, bool valid) const {
+        using target = std::tuple_element_t<I, std::tuple<Targets...>>;
+        using value_type = decltype(target::value);
+        if (valid) {
+            std::get<I>(c.buffers)[r] = target{unit_scan_value<target>(v * scales[I] + shifts[I])};
+        } else if constexpr (std::is_floating_point_v<value_type>) {
+            std::get<I>(c.buffers)[r] = target{std::numeric_limits<value_type>::quiet_NaN()};
+        } else {
+            std::get<I>(c.buffers)[r] = target{value_type{0}};
+        }
+    }
+
+    // up to chunk_rows rows from [p, last) into c, returns where the next row starts
+    const char* parse_rows(const char* p, const char* last, chunk_type& c) const {
+        c.rows = 0;
+        c.invalid = 0;
+        const char* const readable = end();
+        for (; p < last && c.rows < chunk_rows; c.rows++) {
+            const char* line_break = static_cast<const char*>(std::memchr(p, '\n', last - p));
+            const char* line_end = line_break == nullptr ? last : line_break;
+            std::array<double, column_count> cells;
+            std::array<bool, column_count> valid{};
+            const char* q = p;
+            for (std::size_t field = 0; field < field_columns.size(); field++) {
+                const int column = field_columns[field];
+                if (column >= 0) {
+                    while (q != line_end && (*q == ' ' || *q == '\t')) {
+                        q++;
+                    }
+                    // spreadsheets quote numbers too
+                    const bool quoted = q != line_end && *q == '"';
+                    const std::from_chars_result number = scan_number(q + quoted, line_end, cells[column], readable);
+                    const char* after = number.ptr;
+                    const bool closed = !quoted || (after != line_end && *after == '"');
+                    after += quoted && closed;
+                    while (after != line_end && (*after == ' ' || *after == '\t' || *after == '\r')) {
+                        after++;
+                    }
+                    valid[column] = number.ec == std::errc{} && closed && (after == line_end || *after == ',');
+                    q = valid[column] ? after : skip_field(q, line_end);
+                } else {
+                    q = skip_field(q, line_end);
+                }
+                if (q == line_end) {
+                    break;
+                }
+                q++;
+            }
+            [&]<std::size_t... I>(std::index_sequence<I...>) {
+                (store<I>(c, c.rows, cells[I], valid[I]), ...);
+            }(std::index_sequence_for<Targets...>{});
+            c.invalid += column_count - std::count(valid.begin(), valid.end(), true);
+            p = line_break == nullptr ? last : line_break + 1;
+        }
+        return p;
+    }
+};
+
+#endif //UNITMAKER_UNIT_CSV_H
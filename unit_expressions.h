@@ -0,0 +1,304 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_UNIT_EXPRESSIONS_H
+#define UNITMAKER_UNIT_EXPRESSIONS_H
+
+#include "units.h"
+
+#include <tuple>
+#include <utility>
+
+// Opt-in lazy arithmetic: lazy(unit) starts an expression, and nothing is computed until the expression is converted
+// to a unit. Every conversion factor is folded at compile time against the target unit, leaves of a sum sharing a
+// ratio are added before their single conversion multiply, and any chain of multiplications and divisions applies one
+// combined multiplier and at most one division.
+
+template<typename E>
+struct UnitExpressionBase;
+
+template<typename E>
+concept UnitExpression = std::derived_from<E, UnitExpressionBase<E>>;
+
+template<typename E>
+struct UnitExpressionBase {
+    // the canonical unit of the expression, in the ratio of its first term
+    constexpr auto eval() const {
+        using result_t = CanonicalUnit<typename E::base_type, typename E::ratio, typename E::value_type>;
+        return result_t{self().template evaluate<typename result_t::ratio, typename E::value_type>()};
+    }
+
+    template<UnitType To>
+    requires std::same_as<typename To::base_type, typename E::base_type>
+    constexpr operator To() const {
+        return To{self().template evaluate<typename To::ratio, decltype(To::value)>()};
+    }
+
+private:
+    constexpr const E& self() const {
+        return static_cast<const E&>(*this);
+    }
+};
+
+template<UnitType U, bool Negative = false>
+struct UnitLeaf : public UnitExpressionBase<UnitLeaf<U, Negative>> {
+    U unit;
+
+    explicit constexpr UnitLeaf(const U& u) : unit{u} {}
+
+    using base_type = typename U::base_type;
+    using ratio = typename U::ratio;
+    using value_type = decltype(U::value);
+    static constexpr bool negative = Negative;
+
+    constexpr value_type signed_value() const {
+        if constexpr (Negative) {
+            return -unit.value;
+        } else {
+            return unit.value;
+        }
+    }
+
+    template<RatioType Target, typename Numeric>
+    constexpr Numeric evaluate() const {
+        return scale_value<ConversionFactor<ratio, Target>, Numeric>(signed_value());
+    }
+};
+
+template<typename T>
+inline constexpr bool is_unit_leaf_v = false;
+
+template<UnitType U, bool Negative>
+inline constexpr bool is_unit_leaf_v<UnitLeaf<U, Negative>> = true;
+
+template<UnitExpression ...Terms>
+requires (sizeof...(Terms) > 0)
+struct UnitSum : public UnitExpressionBase<UnitSum<Terms...>> {
+    std::tuple<Terms...> terms;
+
+    explicit constexpr UnitSum(std::tuple<Terms...> t) : terms{std::move(t)} {}
+
+    using base_type = typename std::tuple_element_t<0, std::tuple<Terms...>>::base_type;
+    using ratio = typename std::tuple_element_t<0, std::tuple<Terms...>>::ratio;
+    using value_type = std::common_type_t<typename Terms::value_type...>;
+    static_assert((std::same_as<base_type, typename Terms::base_type> && ...), "UnitSum terms must share a base type");
+
+    template<RatioType Target, typename Numeric>
+    constexpr Numeric evaluate() const {
+        return [this]<std::size_t ...I>(std::index_sequence<I...>) {
+            return (zero<Numeric>() + ... + term<I, Target, Numeric>());
+        }(std::index_sequence_for<Terms...>{});
+    }
+
+private:
+    // -0.0 rather than 0.0 so the padding additions fold away for floating point values
+    template<typename Numeric>
+    static constexpr Numeric zero() {
+        return -Numeric{};
+    }
+
+    template<std::size_t I>
+    using term_t = std::tuple_element_t<I, std::tuple<Terms...>>;
+
+    template<std::size_t I, RatioType Ratio>
+    static constexpr bool leaf_with_ratio() {
+        if constexpr (is_unit_leaf_v<term_t<I>>) {
+            return std::ratio_equal_v<typename term_t<I>::ratio, Ratio>;
+        } else {
+            return false;
+        }
+    }
+
+    // the first leaf of each ratio evaluates its whole group, the rest of the group contributes nothing
+    template<std::size_t I>
+    static constexpr bool leads_group() {
+        return [&]<std::size_t ...J>(std::index_sequence<J...>) {
+            return is_unit_leaf_v<term_t<I>> && !(leaf_with_ratio<J, typename term_t<I>::ratio>() || ...);
+        }(std::make_index_sequence<I>{});
+    }
+
+    template<std::size_t I, RatioType Ratio>
+    constexpr value_type group_value() const {
+        if constexpr (leaf_with_ratio<I, Ratio>()) {
+            return std::get<I>(terms).signed_value();
+        } else {
+            return zero<value_type>();
+        }
+    }
+
+    template<std::size_t I, RatioType Target, typename Numeric>
+    constexpr Numeric term() const {
+        if constexpr (!is_unit_leaf_v<term_t<I>>) {
+            return std::get<I>(terms).template evaluate<Target, Numeric>();
+        } else if constexpr (leads_group<I>()) {
+            using group_ratio = typename term_t<I>::ratio;
+            const value_type sum = [this]<std::size_t ...J>(std::index_sequence<J...>) {
+                return (zero<value_type>() + ... + group_value<J, group_ratio>());
+            }(std::index_sequence_for<Terms...>{});
+            return scale_value<ConversionFactor<group_ratio, Target>, Numeric>(sum);
+        } else {
+            return zero<Numeric>();
+        }
+    }
+};
+
+// expression * multiplier / divisor, with the ratio and dimension of every unit factor folded in at compile time
+template<UnitExpression E, RatioType RatioAdjust, DimensionType DimensionAdjust, typename Scalar>
+struct UnitProduct : public UnitExpressionBase<UnitProduct<E, RatioAdjust, DimensionAdjust, Scalar>> {
+    E expression;
+    Scalar multiplier;
+    Scalar divisor;
+
+    constexpr UnitProduct(const E& e, Scalar m, Scalar d) : expression{e}, multiplier{m}, divisor{d} {}
+
+    using inner_type = E;
+    using ratio_adjust = RatioAdjust;
+    using dimension_adjust = DimensionAdjust;
+    using scalar_type = Scalar;
+
+    using base_type = typename DimensionProduct<typename E::base_type, DimensionAdjust>::type;
+    using ratio = std::ratio_multiply<typename E::ratio, RatioAdjust>;
+    using value_type = std::common_type_t<typename E::value_type, Scalar>;
+
+    template<RatioType Target, typename Numeric>
+    constexpr Numeric evaluate() const {
+        const Numeric inner = expression.template evaluate<std::ratio_divide<Target, RatioAdjust>, Numeric>();
+        if constexpr (std::is_integral_v<Numeric>) {
+            return static_cast<Numeric>(inner * multiplier / divisor);
+        } else {
+            return static_cast<Numeric>(inner * static_cast<Numeric>(multiplier / divisor));
+        }
+    }
+};
+
+template<typename T>
+inline constexpr bool is_unit_sum_v = false;
+
+template<UnitExpression ...Terms>
+inline constexpr bool is_unit_sum_v<UnitSum<Terms...>> = true;
+
+template<typename T>
+inline constexpr bool is_unit_product_v = false;
+
+template<UnitExpression E, RatioType R, DimensionType D, typename S>
+inline constexpr bool is_unit_product_v<UnitProduct<E, R, D, S>> = true;
+
+template<typename T>
+concept UnitOperand = UnitExpression<T> || UnitType<T>;
+
+template<UnitType U>
+constexpr UnitLeaf<U> lazy(const U& unit) {
+    return UnitLeaf<U>{unit};
+}
+
+template<UnitOperand T>
+constexpr auto to_unit_sum(const T& t) {
+    if constexpr (is_unit_sum_v<T>) {
+        return t;
+    } else if constexpr (UnitExpression<T>) {
+        return UnitSum<T>{std::tuple<T>{t}};
+    } else {
+        return UnitSum<UnitLeaf<T>>{std::tuple<UnitLeaf<T>>{UnitLeaf<T>{t}}};
+    }
+}
+
+template<UnitExpression ...Terms1, UnitExpression ...Terms2>
+constexpr UnitSum<Terms1..., Terms2...> concat_unit_sums(const UnitSum<Terms1...>& s1, const UnitSum<Terms2...>& s2) {
+    return UnitSum<Terms1..., Terms2...>{std::tuple_cat(s1.terms, s2.terms)};
+}
+
+template<UnitExpression E>
+constexpr auto negate(const E& e) {
+    if constexpr (is_unit_leaf_v<E>) {
+        using unit_t = decltype(e.unit);
+        return UnitLeaf<unit_t, !E::negative>{e.unit};
+    } else if constexpr (is_unit_sum_v<E>) {
+        return std::apply([](const auto& ...terms) {
+            return UnitSum<decltype(negate(terms))...>{std::tuple{negate(terms)...}};
+        }, e.terms);
+    } else {
+        return E{e.expression, -e.multiplier, e.divisor};
+    }
+}
+
+template<UnitExpression E, RatioType RatioAdjust, DimensionType DimensionAdjust, typename Scalar>
+constexpr auto scale_expression(const E& e, Scalar multiplier, Scalar divisor) {
+    if constexpr (is_unit_product_v<E>) {
+        using scalar_t = std::common_type_t<typename E::scalar_type, Scalar>;
+        using product_t = UnitProduct<typename E::inner_type,
+                std::ratio_multiply<typename E::ratio_adjust, RatioAdjust>,
+                typename DimensionProduct<typename E::dimension_adjust, DimensionAdjust>::type,
+                scalar_t>;
+        return product_t{e.expression,
+                static_cast<scalar_t>(e.multiplier) * static_cast<scalar_t>(multiplier),
+                static_cast<scalar_t>(e.divisor) * static_cast<scalar_t>(divisor)};
+    } else {
+        using scalar_t = std::common_type_t<typename E::value_type, Scalar>;
+        return UnitProduct<E, RatioAdjust, DimensionAdjust, scalar_t>{e,
+                static_cast<scalar_t>(multiplier), static_cast<scalar_t>(divisor)};
+    }
+}
+
+template<UnitOperand T1, UnitOperand T2>
+requires (UnitExpression<T1> || UnitExpression<T2>) && std::same_as<typename T1::base_type, typename T2::base_type>
+constexpr auto operator+(const T1& t1, const T2& t2) {
+    return concat_unit_sums(to_unit_sum(t1), to_unit_sum(t2));
+}
+
+template<UnitOperand T1, UnitOperand T2>
+requires (UnitExpression<T1> || UnitExpression<T2>) && std::same_as<typename T1::base_type, typename T2::base_type>
+constexpr auto operator-(const T1& t1, const T2& t2) {
+    return t1 + negate(to_unit_sum(t2));
+}
+
+template<UnitExpression E>
+constexpr auto operator-(const E& e) {
+    return negate(e);
+}
+
+template<UnitExpression E, typename S>
+requires std::is_arithmetic_v<S>
+constexpr auto operator*(const E& e, S s) {
+    return scale_expression<E, std::ratio<1, 1>, Dimensionless>(e, s, S{1});
+}
+
+template<typename S, UnitExpression E>
+requires std::is_arithmetic_v<S>
+constexpr auto operator*(S s, const E& e) {
+    return scale_expression<E, std::ratio<1, 1>, Dimensionless>(e, s, S{1});
+}
+
+template<UnitExpression E, typename S>
+requires std::is_arithmetic_v<S>
+constexpr auto operator/(const E& e, S s) {
+    return scale_expression<E, std::ratio<1, 1>, Dimensionless>(e, S{1}, s);
+}
+
+template<UnitExpression E, UnitOperand U>
+constexpr auto operator*(const E& e, const U& u) {
+    if constexpr (UnitExpression<U>) {
+        return e * u.eval();
+    } else {
+        using numeric_t = decltype(U::value);
+        return scale_expression<E, typename U::ratio, typename U::base_type>(e, u.value, numeric_t{1});
+    }
+}
+
+template<UnitType U, UnitExpression E>
+constexpr auto operator*(const U& u, const E& e) {
+    return e * u;
+}
+
+template<UnitExpression E, UnitOperand U>
+constexpr auto operator/(const E& e, const U& u) {
+    if constexpr (UnitExpression<U>) {
+        return e / u.eval();
+    } else {
+        using numeric_t = decltype(U::value);
+        return scale_expression<E, std::ratio_divide<std::ratio<1, 1>, typename U::ratio>,
+                typename DimensionInverse<typename U::base_type>::type>(e, numeric_t{1}, u.value);
+    }
+}
+
+#endif //UNITMAKER_UNIT_EXPRESSIONS_H
@@ -0,0 +1,649 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_UNIT_FORMAT_H
+#define UNITMAKER_UNIT_FORMAT_H
+
+#include "unit_symbols.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <version>
+#ifdef __cpp_lib_format
+#include <format>
+#endif
+
+// Units written as their value and a symbol, eg. "22.2411 N", straight into caller-provided memory through
+// std::to_chars. The symbol of every unit type is worked out at compile time: the preferred symbol of unit_symbols.h
+// with the same dimension, ratio and offset ("N", "kPa", "°F"), otherwise one or two symbols multiplied or divided
+// ("ft*lbf", "ft/s^2"), otherwise the SI base units ("kg*m/s^3") behind the ratio when it is not 1.
+
+template<typename U>
+concept FormattableUnit = UnitType<U> || UnitOffsetType<U>;
+
+struct UnitSymbolText {
+    static constexpr std::size_t capacity = 64;
+
+    char text[capacity]{};
+    std::size_t length = 0;
+
+    constexpr void append(std::string_view s) {
+        assert(length + s.size() <= capacity && "Unit symbol too long");
+        std::copy(s.begin(), s.end(), text + length);
+        length += s.size();
+    }
+
+    constexpr void append(std::intmax_t n) {
+        if (n < 0) {
+            append("-");
+        }
+        char digits[20]{};
+        int count = 0;
+        for (std::uintmax_t u = n < 0 ? 0 - static_cast<std::uintmax_t>(n) : n; u != 0 || count == 0; u /= 10) {
+            digits[count++] = static_cast<char>('0' + u % 10);
+        }
+        while (count > 0) {
+            append({&digits[--count], 1});
+        }
+    }
+
+    constexpr std::string_view view() const {
+        return {text, length};
+    }
+};
+
+inline constexpr std::string_view unit_base_type_symbols[dimension_lanes] = {
+    "kg", "m", "s", "K", "A", "cd", "custom0", "custom1"
+};
+
+// symbol^exponent, the ^ left out for 1
+constexpr void append_unit_power(UnitSymbolText& out, std::string_view symbol, int exponent) {
+    out.append(symbol);
+    if (exponent != 1) {
+        out.append("^");
+        out.append(exponent);
+    }
+}
+
+// the dimension in SI base units, written so parse_unit reads it back, eg. "kg/(m*s^2)"
+constexpr void append_base_units(UnitSymbolText& out, dimension_t dimension) {
+    int numerator = 0;
+    int denominator = 0;
+    for (int lane = 0; lane < dimension_lanes; lane++) {
+        const int e = dimension_exponent(dimension, static_cast<BaseTypes>(lane));
+        numerator += e > 0;
+        denominator += e < 0;
+    }
+    if (numerator == 0 && denominator > 0) {
+        out.append("1");
+    }
+    for (int lane = 0, written = 0; lane < dimension_lanes; lane++) {
+        const int e = dimension_exponent(dimension, static_cast<BaseTypes>(lane));
+        if (e > 0) {
+            out.append(written++ ? "*" : "");
+            append_unit_power(out, unit_base_type_symbols[lane], e);
+        }
+    }
+    if (denominator > 0) {
+        out.append(denominator > 1 ? "/(" : "/");
+        for (int lane = 0, written = 0; lane < dimension_lanes; lane++) {
+            const int e = dimension_exponent(dimension, static_cast<BaseTypes>(lane));
+            if (e < 0) {
+                out.append(written++ ? "*" : "");
+                append_unit_power(out, unit_base_type_symbols[lane], -e);
+            }
+        }
+        out.append(denominator > 1 ? ")" : "");
+    }
+}
+
+// factors of different symbols are at least a few percent apart, so this only absorbs rounding
+constexpr bool same_unit_factor(double a, double b) {
+    const double difference = a > b ? a - b : b - a;
+    return difference <= (a > b ? a : b) * 1e-12;
+}
+
+constexpr dimension_t dimension_power(dimension_t dimension, int exponent) {
+    dimension_t result = 0;
+    for (int i = 0; i < exponent; i++) {
+        result = dimension_multiply(result, dimension);
+    }
+    return result;
+}
+
+// only the unprefixed symbols, for writing products of two of them
+inline constexpr std::size_t unit_plain_symbols = std::size(unit_base_symbols);
+
+constexpr const UnitSymbol* find_preferred_symbol(dimension_t dimension, double factor, std::size_t count,
+                                                  std::intmax_t offset_num = 0, std::intmax_t offset_den = 1) {
+    for (std::size_t i = 0; i < count; i++) {
+        const UnitSymbol& s = unit_symbols[i];
+        if (s.preferred && s.dimension == dimension && s.offset_num == offset_num && s.offset_den == offset_den
+                && same_unit_factor(s.factor, factor)) {
+            return &s;
+        }
+    }
+    return nullptr;
+}
+
+// sum of the absolute exponents, how many base units a symbol stands for
+constexpr int dimension_weight(dimension_t dimension) {
+    int weight = 0;
+    for (int lane = 0; lane < dimension_lanes; lane++) {
+        const int e = dimension_exponent(dimension, static_cast<BaseTypes>(lane));
+        weight += e < 0 ? -e : e;
+    }
+    return weight;
+}
+
+// a plain symbol, possibly behind one of unit_prefixes, eg. "km"
+struct UnitSymbolTerm {
+    std::size_t symbol = unit_plain_symbols;
+    const UnitPrefix* prefix = nullptr;
+
+    constexpr bool found() const {
+        return symbol < unit_plain_symbols;
+    }
+
+    constexpr void append_to(UnitSymbolText& out, int exponent = 1) const {
+        out.append(prefix != nullptr ? prefix->text : "");
+        append_unit_power(out, unit_symbols[symbol].name(), exponent);
+    }
+};
+
+constexpr UnitSymbolTerm find_symbol_term(dimension_t dimension, double factor) {
+    for (std::size_t i = 0; i < unit_plain_symbols; i++) {
+        const UnitSymbol& s = unit_symbols[i];
+        if (!s.preferred || s.has_offset() || s.dimension != dimension) {
+            continue;
+        }
+        if (same_unit_factor(s.factor, factor)) {
+            return {i, nullptr};
+        }
+        for (const UnitPrefix& prefix : unit_prefixes) {
+            if (s.prefixable && same_unit_factor(s.factor * rounded_quotient(prefix.num, prefix.den), factor)) {
+                return {i, &prefix};
+            }
+        }
+    }
+    return {};
+}
+
+// the lightest of a^k, a*b^k and a/b^k for symbols a and b and k up to 3, a possibly prefixed, eg. "km/h" or "ft/s^2"
+constexpr bool append_symbol_product(UnitSymbolText& out, dimension_t dimension, double factor) {
+    UnitSymbolTerm best_a;
+    std::size_t best_b = unit_plain_symbols;
+    int best_k = 0;
+    bool best_divides = false;
+    int best_weight = std::numeric_limits<int>::max();
+    for (int k = 2; k <= 3; k++) {
+        for (std::size_t a = 0; a < unit_plain_symbols; a++) {
+            const UnitSymbol& s = unit_symbols[a];
+            if (!s.preferred || s.has_offset() || dimension_power(s.dimension, k) != dimension
+                    || dimension_weight(s.dimension) * k >= best_weight) {
+                continue;
+            }
+            for (std::size_t p = 0; p <= std::size(unit_prefixes); p++) {
+                const UnitPrefix* prefix = p > 0 ? &unit_prefixes[p - 1] : nullptr;
+                if (prefix != nullptr && !s.prefixable) {
+                    break;
+                }
+                const double term = s.factor * (prefix != nullptr ? rounded_quotient(prefix->num, prefix->den) : 1.0);
+                double power = 1.0;
+                for (int i = 0; i < k; i++) {
+                    power *= term;
+                }
+                if (same_unit_factor(power, factor)) {
+                    best_a = {a, prefix};
+                    best_k = k;
+                    best_weight = dimension_weight(s.dimension) * k;
+                    break;
+                }
+            }
+        }
+    }
+    for (int k = 1; k <= 3; k++) {
+        for (std::size_t b = 0; b < unit_plain_symbols; b++) {
+            const UnitSymbol& s = unit_symbols[b];
+            if (!s.preferred || s.has_offset() || s.dimension == 0 || dimension_inverse_overflows(s.dimension)) {
+                continue;
+            }
+            const dimension_t db = dimension_power(s.dimension, k);
+            double fb = 1.0;
+            for (int i = 0; i < k; i++) {
+                fb *= s.factor;
+            }
+            for (const bool divides : {false, true}) {
+                const dimension_t da = dimension_multiply(dimension, divides ? db : dimension_inverse(db));
+                const UnitSymbolTerm a = find_symbol_term(da, divides ? factor * fb : factor / fb);
+                const int weight = dimension_weight(da) + dimension_weight(s.dimension) * k;
+                if (a.found() && a.symbol != b && weight < best_weight) {
+                    best_a = a;
+                    best_b = b;
+                    best_k = k;
+                    best_divides = divides;
+                    best_weight = weight;
+                }
+            }
+        }
+    }
+    if (!best_a.found()) {
+        return false;
+    }
+    if (best_b == unit_plain_symbols) {
+        best_a.append_to(out, best_k);
+    } else if (!best_divides && best_k == 1 && best_a.prefix == nullptr && best_b < best_a.symbol) {
+        // a product of two plain symbols in table order, "ft*lbf" whichever was found first
+        out.append(unit_symbols[best_b].name());
+        out.append("*");
+        best_a.append_to(out);
+    } else {
+        best_a.append_to(out);
+        out.append(best_divides ? "/" : "*");
+        append_unit_power(out, unit_symbols[best_b].name(), best_k);
+    }
+    return true;
+}
+
+constexpr UnitSymbolText make_unit_symbol_text(dimension_t dimension, std::intmax_t num, std::intmax_t den,
+                                               std::intmax_t offset_num, std::intmax_t offset_den) {
+    UnitSymbolText out;
+    const double factor = rounded_quotient(num, den);
+    if (const UnitSymbol* s = find_preferred_symbol(dimension, factor, unit_symbols.size(), offset_num, offset_den)) {
+        out.append(s->name());
+        return out;
+    }
+    if (offset_num == 0 && !(num == 1 && den == 1) && append_symbol_product(out, dimension, factor)) {
+        return out;
+    }
+    if (!(num == 1 && den == 1)) {
+        out.append("(");
+        out.append(num);
+        out.append(den == 1 ? "" : "/");
+        if (den != 1) {
+            out.append(den);
+        }
+        out.append(dimension == 0 ? ")" : ")*");
+    }
+    append_base_units(out, dimension);
+    if (offset_num != 0) {
+        out.append(offset_num > 0 ? "+" : "");
+        out.append(offset_num);
+        if (offset_den != 1) {
+            out.append("/");
+            out.append(offset_den);
+        }
+    }
+    return out;
+}
+
+template<typename U>
+struct UnitSymbolOf {
+    static constexpr UnitSymbolText text = make_unit_symbol_text(U::base_type::packed, U::ratio::num, U::ratio::den, 0, 1);
+};
+
+template<UnitOffsetType U>
+struct UnitSymbolOf<U> {
+    using unit_t = typename UnitOffsetTraits<U>::unit_type;
+    using offset_t = typename UnitOffsetTraits<U>::offset;
+    static constexpr UnitSymbolText text = make_unit_symbol_text(unit_t::base_type::packed, unit_t::ratio::num,
+            unit_t::ratio::den, offset_t::num, offset_t::den);
+};
+
+// eg. "N" for Newton, "ft*lbf" for FootPound, empty for a dimensionless ratio of 1
+template<FormattableUnit U>
+constexpr std::string_view unit_symbol() {
+    return UnitSymbolOf<U>::text.view();
+}
+
+// how values are written, the arguments of std::to_chars; a negative precision asks for the shortest representation
+// that reads back to the same value
+struct UnitFormat {
+    std::chars_format format = std::chars_format::general;
+    int precision = 6;
+};
+
+template<typename T>
+using unit_chars_value_t = std::conditional_t<FixedPointType<T>, double, T>;
+
+// the most characters unit_to_chars can write for a unit of type U
+template<FormattableUnit U>
+constexpr std::size_t unit_chars_max(UnitFormat format = {}) {
+    using value_t = unit_chars_value_t<decltype(U::value)>;
+    std::size_t value_chars;
+    if constexpr (std::is_integral_v<value_t>) {
+        value_chars = std::numeric_limits<value_t>::digits10 + 2;
+    } else {
+        const std::size_t digits = format.precision < 0 ? std::numeric_limits<value_t>::max_digits10 : format.precision;
+        const std::size_t integer = format.format == std::chars_format::fixed ? std::numeric_limits<value_t>::max_exponent10 + 1 : 1;
+        // sign, integer digits, point, fraction digits and "e+308"
+        value_chars = 1 + integer + 1 + digits + 6;
+    }
+    const std::size_t symbol = unit_symbol<U>().size();
+    return value_chars + (symbol == 0 ? 0 : symbol + 1);
+}
+
+template<typename T>
+std::to_chars_result unit_value_to_chars(char* first, char* last, T value, UnitFormat format) {
+    if constexpr (FixedPointType<T>) {
+        return unit_value_to_chars(first, last, static_cast<double>(value), format);
+    } else if constexpr (std::is_integral_v<T>) {
+        return std::to_chars(first, last, value);
+    } else if (format.precision < 0) {
+        return std::to_chars(first, last, value, format.format);
+    } else {
+        return std::to_chars(first, last, value, format.format, format.precision);
+    }
+}
+
+// writes "value symbol" into [first, last) like std::to_chars: on success ptr is one past the last character written,
+// otherwise ec is std::errc::value_too_large and ptr is last. Never allocates.
+template<FormattableUnit U>
+std::to_chars_result unit_to_chars(char* first, char* last, const U& unit, UnitFormat format = {}) {
+    constexpr std::string_view symbol = unit_symbol<U>();
+    std::to_chars_result result = unit_value_to_chars(first, last, unit.value, format);
+    if constexpr (!symbol.empty()) {
+        if (result.ec != std::errc{} || static_cast<std::size_t>(last - result.ptr) < symbol.size() + 1) {
+            return {last, std::errc::value_too_large};
+        }
+        *result.ptr++ = ' ';
+        std::memcpy(result.ptr, symbol.data(), symbol.size());
+        result.ptr += symbol.size();
+    }
+    return result;
+}
+
+// every unit of units, each followed by separator, one after another into [first, last); a buffer of
+// units.size() * (unit_chars_max<U>(format) + separator.size()) characters always fits them
+template<FormattableUnit U>
+std::to_chars_result units_to_chars(char* first, char* last, std::span<const U> units, std::string_view separator = "\n",
+                                    UnitFormat format = {}) {
+    for (const U& unit : units) {
+        std::to_chars_result result = unit_to_chars(first, last, unit, format);
+        if (result.ec != std::errc{} || static_cast<std::size_t>(last - result.ptr) < separator.size()) {
+            return {last, std::errc::value_too_large};
+        }
+        std::memcpy(result.ptr, separator.data(), separator.size());
+        first = result.ptr + separator.size();
+    }
+    return {first, std::errc{}};
+}
+
+// UTF-8 characters in s, each counted as one column wide, which is how units are padded to a width
+constexpr std::size_t unit_text_columns(std::string_view s) {
+    return static_cast<std::size_t>(std::count_if(s.begin(), s.end(), [](char c) {
+        return (static_cast<unsigned char>(c) & 0xc0) != 0x80;
+    }));
+}
+
+// formatted on the stack and written in one call, following the stream's precision, fixed or scientific flags and
+// width, which pads "value symbol" as a whole and is reset afterwards as it is for numbers
+template<FormattableUnit U>
+std::ostream& operator<<(std::ostream& os, const U& unit) {
+    UnitFormat format{std::chars_format::general, static_cast<int>(os.precision())};
+    const std::ios_base::fmtflags floatfield = os.flags() & std::ios_base::floatfield;
+    if (floatfield == std::ios_base::fixed) {
+        format.format = std::chars_format::fixed;
+    } else if (floatfield == std::ios_base::scientific) {
+        format.format = std::chars_format::scientific;
+    } else if (floatfield == (std::ios_base::fixed | std::ios_base::scientific)) {
+        format = {std::chars_format::hex, -1};
+    }
+    // a large precision, or fixed notation of a large value, goes to a heap buffer that always fits
+    char buffer[128];
+    std::string heap;
+    std::string_view text;
+    std::to_chars_result result = unit_to_chars(buffer, buffer + sizeof(buffer), unit, format);
+    if (result.ec == std::errc{}) {
+        text = {buffer, static_cast<std::size_t>(result.ptr - buffer)};
+    } else {
+        heap.resize(unit_chars_max<U>(format));
+        result = unit_to_chars(heap.data(), heap.data() + heap.size(), unit, format);
+        if (result.ec != std::errc{}) {
+            os.setstate(std::ios_base::failbit);
+            return os;
+        }
+        text = {heap.data(), static_cast<std::size_t>(result.ptr - heap.data())};
+    }
+
+    const std::size_t width = os.width() > 0 ? static_cast<std::size_t>(os.width()) : 0;
+    os.width(0);
+    const std::size_t columns = unit_text_columns(text);
+    const std::size_t padding = width > columns ? width - columns : 0;
+    const bool left = (os.flags() & std::ios_base::adjustfield) == std::ios_base::left;
+    const char fill = os.fill();
+    for (std::size_t i = 0; !left && i < padding; i++) {
+        os.put(fill);
+    }
+    os.write(text.data(), static_cast<std::streamsize>(text.size()));
+    for (std::size_t i = 0; left && i < padding; i++) {
+        os.put(fill);
+    }
+    return os;
+}
+
+#ifdef __cpp_lib_format
+// std::format("{:>12.2f}", unit) pads "value symbol" as a whole to the width, in characters rather than bytes, and formats
+// the value with the rest of the specification as usual for its type; 0 instead pads the value with zeros to what the
+// symbol leaves of the width. Units are right aligned by default, as numbers are
+template<FormattableUnit U>
+struct std::formatter<U, char> {
+    constexpr auto parse(std::format_parse_context& ctx) {
+        auto it = ctx.begin();
+        const auto end = ctx.end();
+        const auto is_align = [](char c) { return c == '<' || c == '^' || c == '>'; };
+        // the fill is one UTF-8 character
+        const unsigned char lead = it == end ? 0 : static_cast<unsigned char>(*it);
+        const std::ptrdiff_t fill_length = lead >= 0xf0 ? 4 : lead >= 0xe0 ? 3 : lead >= 0xc0 ? 2 : 1;
+        if (end - it > fill_length && is_align(it[fill_length]) && *it != '{' && *it != '}') {
+            std::copy(it, it + fill_length, fill);
+            fill_size = fill_length;
+            align = it[fill_length];
+            it += fill_length + 1;
+        } else if (it != end && is_align(*it)) {
+            align = *it++;
+        }
+
+        // the value's specification with its width and precision taken from arguments 1 and 2, eg. "{0:+0{1}.{2}e}"
+        append("{0:");
+        if (it != end && (*it == '+' || *it == '-' || *it == ' ')) {
+            append(*it++);
+        }
+        if (it != end && *it == '#') {
+            append(*it++);
+        }
+        if (it != end && *it == '0') {
+            // as with numbers, 0 is ignored when an alignment is given
+            zero = align == 0;
+            it++;
+        }
+        it = parse_count(ctx, it, width);
+        if (zero) {
+            append(width.given ? "0{1}" : "0");
+        }
+        if (it != end && *it == '.') {
+            it = parse_count(ctx, it + 1, precision);
+            if (!precision.given) {
+                throw std::format_error{"missing precision in the format of a unit"};
+            }
+            append(".{2}");
+        }
+        while (it != end && *it != '}') {
+            append(*it++);
+        }
+        append('}');
+
+        // the value's own formatter checks the rest, at compile time for a constant format string
+        std::format_parse_context value_ctx{std::string_view{spec + 3, spec_size - 3}, 3};
+        std::formatter<value_t, char> value_formatter;
+        value_formatter.parse(value_ctx);
+        if (align == 0) {
+            align = '>';
+        }
+        return it;
+    }
+
+    template<typename FormatContext>
+    auto format(const U& unit, FormatContext& ctx) const {
+        constexpr std::string_view symbol = unit_symbol<U>();
+        constexpr std::size_t suffix = symbol.empty() ? 0 : 1 + unit_text_columns(symbol);
+        const std::size_t total_width = width.resolve(ctx);
+        const std::size_t value_width = total_width > suffix ? total_width - suffix : 1;
+        const std::size_t digits = precision.resolve(ctx);
+        const value_t value = static_cast<value_t>(unit.value);
+        const auto args = std::make_format_args(value, value_width, digits);
+
+        // the value on the stack, or on the heap when a width or precision makes it longer than the buffer
+        char buffer[128];
+        std::size_t size = 0;
+        std::vformat_to(BufferIterator{buffer, &size}, std::string_view{spec, spec_size}, args);
+        std::string heap;
+        std::string_view text{buffer, size};
+        if (size > sizeof(buffer)) {
+            heap = std::vformat(std::string_view{spec, spec_size}, args);
+            text = heap;
+        }
+
+        const std::size_t length = unit_text_columns(text) + suffix;
+        const std::size_t padding = total_width > length ? total_width - length : 0;
+        const std::size_t before = align == '<' ? 0 : align == '^' ? padding / 2 : padding;
+        auto out = ctx.out();
+        for (std::size_t i = 0; i < before; i++) {
+            out = std::copy(fill, fill + fill_size, out);
+        }
+        out = std::copy(text.begin(), text.end(), out);
+        if constexpr (!symbol.empty()) {
+            *out++ = ' ';
+            out = std::copy(symbol.begin(), symbol.end(), out);
+        }
+        for (std::size_t i = before; i < padding; i++) {
+            out = std::copy(fill, fill + fill_size, out);
+        }
+        return out;
+    }
+
+private:
+    using value_t = unit_chars_value_t<decltype(U::value)>;
+
+    // a width or precision, written out or taken from an argument by {} or {n}
+    struct Count {
+        bool given = false;
+        bool dynamic = false;
+        std::size_t value = 0;
+
+        template<typename FormatContext>
+        std::size_t resolve(FormatContext& ctx) const {
+            if (!dynamic) {
+                return value;
+            }
+            return std::visit_format_arg([](auto arg) -> std::size_t {
+                using arg_t = decltype(arg);
+                if constexpr (std::is_integral_v<arg_t> && !std::is_same_v<arg_t, bool> && !std::is_same_v<arg_t, char>) {
+                    if constexpr (std::is_signed_v<arg_t>) {
+                        if (arg < 0) {
+                            throw std::format_error{"negative width or precision in the format of a unit"};
+                        }
+                    }
+                    return static_cast<std::size_t>(arg);
+                } else {
+                    throw std::format_error{"width or precision of a unit is not an integer"};
+                }
+            }, ctx.arg(value));
+        }
+    };
+
+    // writes into a buffer of 128 characters, counting the characters that do not fit as well
+    struct BufferIterator {
+        using iterator_category = std::output_iterator_tag;
+        using value_type = void;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = void;
+
+        char* buffer;
+        std::size_t* size;
+
+        BufferIterator& operator*() {
+            return *this;
+        }
+
+        BufferIterator& operator=(char c) {
+            if (*size < 128) {
+                buffer[*size] = c;
+            }
+            ++*size;
+            return *this;
+        }
+
+        BufferIterator& operator++() {
+            return *this;
+        }
+
+        BufferIterator operator++(int) {
+            return *this;
+        }
+    };
+
+    char fill[4] = {' '};
+    std::size_t fill_size = 1;
+    char align = 0;
+    bool zero = false;
+    Count width;
+    Count precision;
+    char spec[32]{};
+    std::size_t spec_size = 0;
+
+    constexpr void append(std::string_view s) {
+        if (spec_size + s.size() > sizeof(spec)) {
+            throw std::format_error{"format of a unit too long"};
+        }
+        std::copy(s.begin(), s.end(), spec + spec_size);
+        spec_size += s.size();
+    }
+
+    constexpr void append(char c) {
+        append(std::string_view{&c, 1});
+    }
+
+    static constexpr std::format_parse_context::iterator parse_count(std::format_parse_context& ctx,
+            std::format_parse_context::iterator it, Count& count) {
+        const auto end = ctx.end();
+        const auto digits = [&] {
+            std::size_t n = 0;
+            for (; it != end && *it >= '0' && *it <= '9'; it++) {
+                n = n * 10 + static_cast<std::size_t>(*it - '0');
+            }
+            return n;
+        };
+        if (it != end && *it >= '0' && *it <= '9') {
+            count = {true, false, digits()};
+        } else if (it != end && *it == '{') {
+            it++;
+            if (it != end && *it == '}') {
+                count = {true, true, ctx.next_arg_id()};
+            } else {
+                const std::size_t id = digits();
+                ctx.check_arg_id(id);
+                count = {true, true, id};
+            }
+            if (it == end || *it != '}') {
+                throw std::format_error{"invalid argument for the width or precision of a unit"};
+            }
+            it++;
+        }
+        return it;
+    }
+};
+#endif
+
+#endif //UNITMAKER_UNIT_FORMAT_H
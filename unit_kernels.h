@@ -0,0 +1,238 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_UNIT_KERNELS_H
+#define UNITMAKER_UNIT_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Loops over raw unit values shared by unit_array.h and unit_convert.h. Every kernel only reads the index it writes,
+// so the output may alias an input.
+
+// float and double kernels are compiled for several instruction sets and picked at load time where the toolchain
+// supports it, define UNITMAKER_NO_SIMD_DISPATCH to build only for the target the translation unit is compiled for.
+// ThreadSanitizer builds never dispatch: the resolvers that pick a clone run before the sanitizer's runtime is set up
+// and crash the program at startup.
+#if defined(__SANITIZE_THREAD__) && !defined(UNITMAKER_NO_SIMD_DISPATCH)
+#define UNITMAKER_NO_SIMD_DISPATCH
+#elif defined(__has_feature) && !defined(UNITMAKER_NO_SIMD_DISPATCH)
+#if __has_feature(thread_sanitizer)
+#define UNITMAKER_NO_SIMD_DISPATCH
+#endif
+#endif
+#if defined(__GNUC__) && !defined(__clang__)
+#define UNITMAKER_VECTORIZE , optimize("tree-vectorize", "vect-cost-model=dynamic")
+#define UNITMAKER_IVDEP _Pragma("GCC ivdep")
+#elif defined(__clang__)
+#define UNITMAKER_VECTORIZE
+#define UNITMAKER_IVDEP _Pragma("clang loop vectorize(assume_safety)")
+#else
+#define UNITMAKER_VECTORIZE
+#define UNITMAKER_IVDEP
+#endif
+
+#if defined(__GNUC__)
+#define UNITMAKER_ALWAYS_INLINE __attribute__((always_inline))
+#else
+#define UNITMAKER_ALWAYS_INLINE
+#endif
+
+#if !defined(UNITMAKER_NO_SIMD_DISPATCH) && defined(__x86_64__) && defined(__ELF__) && defined(__has_attribute)
+#if __has_attribute(target_clones)
+#define UNITMAKER_SIMD_CLONES target_clones("arch=x86-64-v4", "arch=x86-64-v3", "default")
+#define UNITMAKER_SIMD_DISPATCH __attribute__((UNITMAKER_SIMD_CLONES UNITMAKER_VECTORIZE))
+#endif
+#endif
+#ifndef UNITMAKER_SIMD_DISPATCH
+#define UNITMAKER_SIMD_DISPATCH
+#endif
+
+enum class ArrayOp {
+    ADD, SUBTRACT, MULTIPLY, DIVIDE, MIN, MAX,
+    // scalar kernels only, the scalar is the left operand
+    SUBTRACT_FROM, DIVIDE_INTO
+};
+
+enum class CompareOp {
+    EQUAL, NOT_EQUAL, LESS, LESS_EQUAL, GREATER, GREATER_EQUAL
+};
+
+template<ArrayOp Op, typename T>
+UNITMAKER_ALWAYS_INLINE constexpr T apply_array_op(T a, T b) {
+    if constexpr (Op == ArrayOp::ADD) {
+        return a + b;
+    } else if constexpr (Op == ArrayOp::SUBTRACT) {
+        return a - b;
+    } else if constexpr (Op == ArrayOp::MULTIPLY) {
+        return a * b;
+    } else if constexpr (Op == ArrayOp::DIVIDE) {
+        return a / b;
+    } else if constexpr (Op == ArrayOp::MIN) {
+        return b < a ? b : a;
+    } else if constexpr (Op == ArrayOp::MAX) {
+        return a < b ? b : a;
+    } else if constexpr (Op == ArrayOp::SUBTRACT_FROM) {
+        return b - a;
+    } else {
+        return b / a;
+    }
+}
+
+template<CompareOp Op, typename T>
+UNITMAKER_ALWAYS_INLINE constexpr bool apply_compare_op(T a, T b) {
+    if constexpr (Op == CompareOp::EQUAL) {
+        return a == b;
+    } else if constexpr (Op == CompareOp::NOT_EQUAL) {
+        return a != b;
+    } else if constexpr (Op == CompareOp::LESS) {
+        return a < b;
+    } else if constexpr (Op == CompareOp::LESS_EQUAL) {
+        return a <= b;
+    } else if constexpr (Op == CompareOp::GREATER) {
+        return a > b;
+    } else {
+        return a >= b;
+    }
+}
+
+// out[i] = a[i] op (b[i] * k), the multiply is skipped when k is 1. b[i] * k is taken in double and rounded to T once,
+// as a unit conversion rounds it, so float elements give the same bits as the scalar operators.
+template<typename T>
+UNITMAKER_ALWAYS_INLINE inline void array_binary_kernel(ArrayOp op, const T* a, const T* b, double k, T* out, std::size_t n) {
+    auto loop = [=]<ArrayOp Op>(bool scaled) UNITMAKER_ALWAYS_INLINE {
+        if (scaled) {
+            UNITMAKER_IVDEP
+            for (std::size_t i = 0; i < n; i++) {
+                out[i] = apply_array_op<Op>(a[i], static_cast<T>(b[i] * k));
+            }
+        } else {
+            UNITMAKER_IVDEP
+            for (std::size_t i = 0; i < n; i++) {
+                out[i] = apply_array_op<Op>(a[i], b[i]);
+            }
+        }
+    };
+    const bool scaled = k != 1.0;
+    switch (op) {
+        case ArrayOp::ADD: loop.template operator()<ArrayOp::ADD>(scaled); break;
+        case ArrayOp::SUBTRACT: loop.template operator()<ArrayOp::SUBTRACT>(scaled); break;
+        case ArrayOp::MULTIPLY: loop.template operator()<ArrayOp::MULTIPLY>(scaled); break;
+        case ArrayOp::DIVIDE: loop.template operator()<ArrayOp::DIVIDE>(scaled); break;
+        case ArrayOp::MIN: loop.template operator()<ArrayOp::MIN>(scaled); break;
+        case ArrayOp::MAX: loop.template operator()<ArrayOp::MAX>(scaled); break;
+        case ArrayOp::SUBTRACT_FROM: loop.template operator()<ArrayOp::SUBTRACT_FROM>(scaled); break;
+        case ArrayOp::DIVIDE_INTO: loop.template operator()<ArrayOp::DIVIDE_INTO>(scaled); break;
+    }
+}
+
+// out[i] = a[i] op s
+template<typename T>
+UNITMAKER_ALWAYS_INLINE inline void array_scalar_kernel(ArrayOp op, const T* a, T s, T* out, std::size_t n) {
+    auto loop = [=]<ArrayOp Op>() UNITMAKER_ALWAYS_INLINE {
+        UNITMAKER_IVDEP
+        for (std::size_t i = 0; i < n; i++) {
+            out[i] = apply_array_op<Op>(a[i], s);
+        }
+    };
+    switch (op) {
+        case ArrayOp::ADD: loop.template operator()<ArrayOp::ADD>(); break;
+        case ArrayOp::SUBTRACT: loop.template operator()<ArrayOp::SUBTRACT>(); break;
+        case ArrayOp::MULTIPLY: loop.template operator()<ArrayOp::MULTIPLY>(); break;
+        case ArrayOp::DIVIDE: loop.template operator()<ArrayOp::DIVIDE>(); break;
+        case ArrayOp::MIN: loop.template operator()<ArrayOp::MIN>(); break;
+        case ArrayOp::MAX: loop.template operator()<ArrayOp::MAX>(); break;
+        case ArrayOp::SUBTRACT_FROM: loop.template operator()<ArrayOp::SUBTRACT_FROM>(); break;
+        case ArrayOp::DIVIDE_INTO: loop.template operator()<ArrayOp::DIVIDE_INTO>(); break;
+    }
+}
+
+template<typename T>
+UNITMAKER_ALWAYS_INLINE inline void array_clamp_kernel(const T* a, T low, T high, T* out, std::size_t n) {
+    UNITMAKER_IVDEP
+    for (std::size_t i = 0; i < n; i++) {
+        const T v = a[i] < low ? low : a[i];
+        out[i] = high < v ? high : v;
+    }
+}
+
+// out[i] = a[i] op (b[i] * k), b[i] * k rounded to T once as in array_binary_kernel
+template<typename T>
+UNITMAKER_ALWAYS_INLINE inline void array_compare_kernel(CompareOp op, const T* a, const T* b, double k, std::uint8_t* out, std::size_t n) {
+    auto loop = [=]<CompareOp Op>() UNITMAKER_ALWAYS_INLINE {
+        UNITMAKER_IVDEP
+        for (std::size_t i = 0; i < n; i++) {
+            out[i] = apply_compare_op<Op>(a[i], static_cast<T>(b[i] * k));
+        }
+    };
+    switch (op) {
+        case CompareOp::EQUAL: loop.template operator()<CompareOp::EQUAL>(); break;
+        case CompareOp::NOT_EQUAL: loop.template operator()<CompareOp::NOT_EQUAL>(); break;
+        case CompareOp::LESS: loop.template operator()<CompareOp::LESS>(); break;
+        case CompareOp::LESS_EQUAL: loop.template operator()<CompareOp::LESS_EQUAL>(); break;
+        case CompareOp::GREATER: loop.template operator()<CompareOp::GREATER>(); break;
+        case CompareOp::GREATER_EQUAL: loop.template operator()<CompareOp::GREATER_EQUAL>(); break;
+    }
+}
+
+// out[i] = a[i] * k, taken in double and rounded to T once, as scale_value converts a single unit
+template<typename T>
+UNITMAKER_ALWAYS_INLINE inline void array_scale_kernel(const T* a, double k, T* out, std::size_t n) {
+    UNITMAKER_IVDEP
+    for (std::size_t i = 0; i < n; i++) {
+        out[i] = static_cast<T>(a[i] * k);
+    }
+}
+
+// out[i] = (a[i] + offset) * k, rounded to T after the offset and again after k, as a UnitOffset converts
+template<typename T>
+UNITMAKER_ALWAYS_INLINE inline void array_offset_scale_kernel(const T* a, double offset, double k, T* out, std::size_t n) {
+    UNITMAKER_IVDEP
+    for (std::size_t i = 0; i < n; i++) {
+        out[i] = static_cast<T>(static_cast<T>(a[i] + offset) * k);
+    }
+}
+
+// out[i] = a[i] * k + c, taken in double and rounded to T once, as a unit column converts a single stored value
+template<typename T>
+UNITMAKER_ALWAYS_INLINE inline void array_affine_kernel(const T* a, double k, double c, T* out, std::size_t n) {
+    UNITMAKER_IVDEP
+    for (std::size_t i = 0; i < n; i++) {
+        out[i] = static_cast<T>(a[i] * k + c);
+    }
+}
+
+#define UNITMAKER_ARRAY_KERNELS(T) \
+    UNITMAKER_SIMD_DISPATCH inline void array_binary(ArrayOp op, const T* a, const T* b, double k, T* out, std::size_t n) { \
+        array_binary_kernel<T>(op, a, b, k, out, n); \
+    } \
+    UNITMAKER_SIMD_DISPATCH inline void array_scalar(ArrayOp op, const T* a, T s, T* out, std::size_t n) { \
+        array_scalar_kernel<T>(op, a, s, out, n); \
+    } \
+    UNITMAKER_SIMD_DISPATCH inline void array_clamp(const T* a, T low, T high, T* out, std::size_t n) { \
+        array_clamp_kernel<T>(a, low, high, out, n); \
+    } \
+    UNITMAKER_SIMD_DISPATCH inline void array_compare(CompareOp op, const T* a, const T* b, double k, std::uint8_t* out, std::size_t n) { \
+        array_compare_kernel<T>(op, a, b, k, out, n); \
+    } \
+    UNITMAKER_SIMD_DISPATCH inline void array_scale(const T* a, double k, T* out, std::size_t n) { \
+        array_scale_kernel<T>(a, k, out, n); \
+    } \
+    UNITMAKER_SIMD_DISPATCH inline void array_offset_scale(const T* a, double offset, double k, T* out, std::size_t n) { \
+        array_offset_scale_kernel<T>(a, offset, k, out, n); \
+    } \
+    UNITMAKER_SIMD_DISPATCH inline void array_affine(const T* a, double k, double c, T* out, std::size_t n) { \
+        array_affine_kernel<T>(a, k, c, out, n); \
+    }
+
+UNITMAKER_ARRAY_KERNELS(float)
+UNITMAKER_ARRAY_KERNELS(double)
+
+#undef UNITMAKER_ARRAY_KERNELS
+
+template<typename T>
+inline constexpr bool array_kernel_type = std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+#endif //UNITMAKER_UNIT_KERNELS_H
@@ -0,0 +1,55 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_UNIT_LITERALS_H
+#define UNITMAKER_UNIT_LITERALS_H
+
+#include "unit_parser.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+
+// Unit strings resolved to unit types while compiling: unit_t<"kN*m"> is the CanonicalUnit the operators produce for
+// that dimension and ratio, the same type as decltype(Kilo<Newton>{1} * Meter{1}), and "ft/s"_u is one of it. The
+// strings follow the grammar of parse_unit, and a string it rejects fails to compile.
+
+template<std::size_t N>
+struct UnitString {
+    char text[N]{};
+
+    constexpr UnitString(const char (&s)[N]) {
+        std::copy_n(s, N, text);
+    }
+
+    constexpr std::string_view view() const {
+        return {text, N - 1};
+    }
+};
+
+template<UnitString S, typename Numeric>
+struct UnitStringType {
+    static constexpr UnitParseResult result = parse_unit(S.view());
+    static_assert(result.error != UnitParseError::EMPTY, "Empty unit string");
+    static_assert(result.error != UnitParseError::UNKNOWN_SYMBOL, "Unknown symbol in unit string");
+    static_assert(result.error != UnitParseError::SYNTAX, "Malformed unit string");
+    static_assert(result.error != UnitParseError::EXPONENT_OUT_OF_RANGE, "Dimension exponent out of range [-128, 127]");
+    static_assert(result.error != UnitParseError::OFFSET_IN_EXPRESSION, "A unit with an offset cannot be part of a larger unit string");
+    static_assert(result.unit.exact, "Unit string ratio does not fit std::intmax_t");
+
+    using unit_type = CanonicalUnit<Dimension<result.unit.dimension>, std::ratio<result.unit.num, result.unit.den>, Numeric>;
+    using type = std::conditional_t<result.unit.offset_num == 0, unit_type,
+            UnitOffset<unit_type, std::ratio<result.unit.offset_num, result.unit.offset_den>, Numeric>>;
+};
+
+template<UnitString S, typename Numeric = double>
+using unit_t = typename UnitStringType<S, Numeric>::type;
+
+// one of the unit, so 12.5 * "ft/s"_u is 12.5 feet per second
+template<UnitString S>
+constexpr unit_t<S> operator""_u() {
+    return unit_t<S>{1};
+}
+
+#endif //UNITMAKER_UNIT_LITERALS_H
@@ -0,0 +1,432 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_UNIT_PARSER_H
+#define UNITMAKER_UNIT_PARSER_H
+
+#include "dynamic_unit.h"
+#include "unit_symbols.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <utility>
+
+// Unit strings such as "kN*m/s^2", "lbf/in^2" or "kg/(m*s^2)" resolved at runtime to a dimension and a factor.
+// Symbols combine with '*', '/', '·' or a space, take integer powers through '^', and group with parentheses; '/'
+// divides by the next power only, so "J/kg*K" is J*K/kg. A lone "degC" or "degF" keeps its offset, but a unit with
+// an offset may not appear inside a larger expression. Nothing here allocates: parse_unit works on the stack, and a
+// UnitParser interns its results in memory the caller hands it through a UnitArena.
+
+enum class UnitParseError {
+    NONE, EMPTY, UNKNOWN_SYMBOL, SYNTAX, EXPONENT_OUT_OF_RANGE, OFFSET_IN_EXPRESSION
+};
+
+struct ParsedUnit {
+    dimension_t dimension = 0;
+    // base units per unit, num / den exactly when exact, and factor rounded either way
+    double factor = 1.0;
+    std::intmax_t num = 1;
+    std::intmax_t den = 1;
+    bool exact = true;
+    // added to a value in this unit before scaling it
+    std::intmax_t offset_num = 0;
+    std::intmax_t offset_den = 1;
+
+    constexpr double offset() const {
+        return static_cast<double>(offset_num) / static_cast<double>(offset_den);
+    }
+
+    // value in this unit as a quantity in base units
+    constexpr DynamicUnit operator()(double value) const {
+        return {value + offset(), dimension, factor};
+    }
+};
+
+struct UnitParseResult {
+    ParsedUnit unit;
+    UnitParseError error = UnitParseError::NONE;
+    // where in the string parsing stopped when it failed
+    std::size_t position = 0;
+
+    constexpr explicit operator bool() const {
+        return error == UnitParseError::NONE;
+    }
+};
+
+class UnitStringParser {
+public:
+    explicit constexpr UnitStringParser(std::string_view text) : text{text.data()}, size{text.size()} {}
+
+    constexpr UnitParseResult parse() {
+        UnitParseResult result;
+        skip_spaces();
+        if (pos == size) {
+            return fail(UnitParseError::EMPTY);
+        }
+        if (!parse_product(result.unit, 0)) {
+            return fail(error);
+        }
+        if (pos != size) {
+            return fail(UnitParseError::SYNTAX);
+        }
+        if (offset_position != npos && terms > 1) {
+            pos = offset_position;
+            return fail(UnitParseError::OFFSET_IN_EXPRESSION);
+        }
+        return result;
+    }
+
+private:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+    static constexpr int max_depth = 16;
+    static constexpr int max_exponent = 127;
+
+    // not a string_view, whose operator[] is a checked call on every character while compiling unit_t literals
+    const char* text;
+    std::size_t size;
+    std::size_t pos = 0;
+    UnitParseError error = UnitParseError::NONE;
+    int terms = 0;
+    std::size_t offset_position = npos;
+
+    constexpr UnitParseResult fail(UnitParseError e) const {
+        UnitParseResult result;
+        result.error = e;
+        result.position = pos;
+        return result;
+    }
+
+    constexpr bool set_error(UnitParseError e) {
+        error = e;
+        return false;
+    }
+
+    static constexpr bool is_symbol_char(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || static_cast<unsigned char>(c) >= 0x80;
+    }
+
+    // U+00B7 middle dot, two bytes in UTF-8
+    constexpr bool at_middle_dot() const {
+        return pos + 1 < size && text[pos] == '\xc2' && text[pos + 1] == '\xb7';
+    }
+
+    constexpr void skip_spaces() {
+        while (pos < size && text[pos] == ' ') {
+            pos++;
+        }
+    }
+
+    constexpr bool parse_product(ParsedUnit& unit, int depth) {
+        if (!parse_power(unit, depth)) {
+            return false;
+        }
+        for (;;) {
+            skip_spaces();
+            bool divide = false;
+            if (pos < size && (text[pos] == '*' || text[pos] == '/')) {
+                divide = text[pos] == '/';
+                pos++;
+            } else if (at_middle_dot()) {
+                pos += 2;
+            } else if (pos == size || !(is_symbol_char(text[pos]) || text[pos] == '(')) {
+                // anything else ends the product, a space between two symbols multiplies them
+                return true;
+            }
+            ParsedUnit next;
+            if (!parse_power(next, depth) || !(divide ? divide_unit(unit, next) : multiply_unit(unit, next))) {
+                return false;
+            }
+        }
+    }
+
+    constexpr bool parse_power(ParsedUnit& unit, int depth) {
+        skip_spaces();
+        if (!parse_primary(unit, depth)) {
+            return false;
+        }
+        skip_spaces();
+        if (pos == size || text[pos] != '^') {
+            return true;
+        }
+        pos++;
+        skip_spaces();
+        bool negative = false;
+        if (pos < size && (text[pos] == '-' || text[pos] == '+')) {
+            negative = text[pos] == '-';
+            pos++;
+        }
+        if (pos == size || text[pos] < '0' || text[pos] > '9') {
+            return set_error(UnitParseError::SYNTAX);
+        }
+        int exponent = 0;
+        for (; pos < size && text[pos] >= '0' && text[pos] <= '9'; pos++) {
+            exponent = exponent * 10 + (text[pos] - '0');
+            if (exponent > max_exponent) {
+                return set_error(UnitParseError::EXPONENT_OUT_OF_RANGE);
+            }
+        }
+        terms++;
+        return power_unit(unit, negative ? -exponent : exponent);
+    }
+
+    constexpr bool parse_primary(ParsedUnit& unit, int depth) {
+        if (pos == size) {
+            return set_error(UnitParseError::SYNTAX);
+        }
+        if (text[pos] == '(') {
+            if (depth == max_depth) {
+                return set_error(UnitParseError::SYNTAX);
+            }
+            pos++;
+            skip_spaces();
+            if (!parse_product(unit, depth + 1)) {
+                return false;
+            }
+            skip_spaces();
+            if (pos == size || text[pos] != ')') {
+                return set_error(UnitParseError::SYNTAX);
+            }
+            pos++;
+            return true;
+        }
+        // "1" for a dimensionless numerator, as in "1/s"
+        if (text[pos] == '1') {
+            pos++;
+            unit = ParsedUnit{};
+            return true;
+        }
+        const std::size_t start = pos;
+        while (pos < size && is_symbol_char(text[pos]) && !at_middle_dot()) {
+            pos++;
+        }
+        if (pos == start) {
+            return set_error(UnitParseError::SYNTAX);
+        }
+        const UnitSymbol* symbol = find_unit_symbol({text + start, pos - start});
+        if (symbol == nullptr) {
+            pos = start;
+            return set_error(UnitParseError::UNKNOWN_SYMBOL);
+        }
+        terms++;
+        if (symbol->has_offset()) {
+            offset_position = start;
+        }
+        unit.dimension = symbol->dimension;
+        unit.factor = symbol->factor;
+        unit.num = symbol->num;
+        unit.den = symbol->den;
+        unit.exact = true;
+        unit.offset_num = symbol->offset_num;
+        unit.offset_den = symbol->offset_den;
+        return true;
+    }
+
+    // a * b, or false when it does not fit intmax_t
+    static constexpr bool checked_multiply(std::intmax_t a, std::intmax_t b, std::intmax_t& out) {
+        const wide_uintmax_t product = static_cast<wide_uintmax_t>(a) * static_cast<wide_uintmax_t>(b);
+        out = static_cast<std::intmax_t>(product);
+        return product <= INTMAX_MAX;
+    }
+
+    static constexpr double power(double base, int exponent) {
+        double result = 1.0;
+        for (; exponent > 0; exponent >>= 1, base *= base) {
+            if (exponent & 1) {
+                result *= base;
+            }
+        }
+        return result;
+    }
+
+    // base^exponent, or false when it does not fit intmax_t
+    static constexpr bool checked_power(std::intmax_t base, int exponent, std::intmax_t& out) {
+        std::intmax_t result = 1;
+        bool fits = true;
+        for (; exponent > 0 && fits; exponent >>= 1) {
+            if (exponent & 1) {
+                fits = checked_multiply(result, base, result);
+            }
+            if (exponent > 1) {
+                fits = fits && checked_multiply(base, base, base);
+            }
+        }
+        out = result;
+        return fits;
+    }
+
+    static constexpr void multiply_ratio(ParsedUnit& unit, std::intmax_t num, std::intmax_t den) {
+        if (!unit.exact) {
+            return;
+        }
+        const std::intmax_t num_gcd = std::gcd(num, unit.den);
+        const std::intmax_t den_gcd = std::gcd(den, unit.num);
+        unit.exact = checked_multiply(unit.num / den_gcd, num / num_gcd, unit.num)
+                && checked_multiply(unit.den / num_gcd, den / den_gcd, unit.den);
+    }
+
+    constexpr bool multiply_unit(ParsedUnit& unit, const ParsedUnit& by) {
+        if (dimension_multiply_overflows(unit.dimension, by.dimension)) {
+            return set_error(UnitParseError::EXPONENT_OUT_OF_RANGE);
+        }
+        unit.dimension = dimension_multiply(unit.dimension, by.dimension);
+        unit.factor *= by.factor;
+        unit.exact = unit.exact && by.exact;
+        multiply_ratio(unit, by.num, by.den);
+        return true;
+    }
+
+    constexpr bool divide_unit(ParsedUnit& unit, const ParsedUnit& by) {
+        if (dimension_inverse_overflows(by.dimension)) {
+            return set_error(UnitParseError::EXPONENT_OUT_OF_RANGE);
+        }
+        ParsedUnit inverse = by;
+        inverse.dimension = dimension_inverse(by.dimension);
+        inverse.factor = 1.0 / by.factor;
+        inverse.num = by.den;
+        inverse.den = by.num;
+        return multiply_unit(unit, inverse);
+    }
+
+    constexpr bool power_unit(ParsedUnit& unit, int exponent) {
+        ParsedUnit result;
+        for (int lane = 0; lane < dimension_lanes; lane++) {
+            const int e = dimension_exponent(unit.dimension, static_cast<BaseTypes>(lane)) * exponent;
+            if (e < -128 || e > 127) {
+                return set_error(UnitParseError::EXPONENT_OUT_OF_RANGE);
+            }
+            result.dimension |= base_dimension(static_cast<BaseTypes>(lane), e);
+        }
+        // num and den are coprime, so their powers are too and need no reducing
+        const int magnitude = exponent < 0 ? -exponent : exponent;
+        result.factor = power(unit.factor, magnitude);
+        result.exact = unit.exact && checked_power(unit.num, magnitude, result.num)
+                && checked_power(unit.den, magnitude, result.den);
+        if (exponent < 0) {
+            result.factor = 1.0 / result.factor;
+            std::swap(result.num, result.den);
+        }
+        unit = result;
+        return true;
+    }
+};
+
+// parses text without caching, usable in constant expressions
+constexpr UnitParseResult parse_unit(std::string_view text) {
+    return UnitStringParser{text}.parse();
+}
+
+// A bump allocator over memory the caller owns. Nothing is freed short of reset(), and allocate returns nullptr once
+// the buffer is used up rather than reaching for the heap.
+class UnitArena {
+public:
+    explicit UnitArena(std::span<std::byte> buffer) : buffer{buffer} {}
+
+    void* allocate(std::size_t bytes, std::size_t alignment) {
+        const auto base = reinterpret_cast<std::uintptr_t>(buffer.data());
+        const std::uintptr_t start = (base + used + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1);
+        if (start - base > buffer.size() || bytes > buffer.size() - (start - base)) {
+            return nullptr;
+        }
+        used = start - base + bytes;
+        return buffer.data() + (start - base);
+    }
+
+    void reset() {
+        used = 0;
+    }
+
+    std::size_t size() const {
+        return used;
+    }
+
+    std::size_t capacity() const {
+        return buffer.size();
+    }
+
+private:
+    std::span<std::byte> buffer;
+    std::size_t used = 0;
+};
+
+// Parses through an open-addressed cache of every distinct string seen so far, so a repeated string costs one hash and
+// one compare. The interned strings and results live in the arena, which must outlive the parser; once the arena or
+// the cache fills, strings not seen before are still parsed but no longer interned. Not thread safe, give each thread
+// its own parser.
+template<std::size_t CacheSlots = 4096>
+requires (std::has_single_bit(CacheSlots))
+class UnitParser {
+public:
+    explicit UnitParser(UnitArena& arena) : arena{arena} {}
+
+    UnitParseResult parse(std::string_view text) {
+        const std::uint64_t hash = hash_text(text);
+        std::size_t slot = static_cast<std::size_t>(hash) & (CacheSlots - 1);
+        for (; entries[slot] != nullptr; slot = (slot + 1) & (CacheSlots - 1)) {
+            const Interned* entry = entries[slot];
+            if (hashes[slot] == hash && std::string_view{entry->text, entry->length} == text) {
+                return entry->result;
+            }
+        }
+
+        const UnitParseResult result = parse_unit(text);
+        // load factor at most 3/4 so probe chains stay short
+        if (interned * 4 < CacheSlots * 3) {
+            auto* chars = static_cast<char*>(arena.allocate(text.size(), 1));
+            auto* entry = static_cast<Interned*>(arena.allocate(sizeof(Interned), alignof(Interned)));
+            if (chars != nullptr && entry != nullptr) {
+                std::copy(text.begin(), text.end(), chars);
+                *entry = Interned{result, chars, text.size()};
+                entries[slot] = entry;
+                hashes[slot] = hash;
+                interned++;
+            }
+        }
+        return result;
+    }
+
+    std::size_t size() const {
+        return interned;
+    }
+
+    // forgets every interned string, the caller may then reset the arena
+    void clear() {
+        entries.fill(nullptr);
+        interned = 0;
+    }
+
+private:
+    struct Interned {
+        UnitParseResult result;
+        const char* text;
+        std::size_t length;
+    };
+
+    static std::uint64_t hash_text(std::string_view text) {
+        std::uint64_t hash = text.size();
+        std::size_t i = 0;
+        for (; i + 8 <= text.size(); i += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, text.data() + i, 8);
+            hash = unit_hash_mix(hash ^ word);
+        }
+        std::uint64_t tail = 0;
+        if (i < text.size()) {
+            std::memcpy(&tail, text.data() + i, text.size() - i);
+        }
+        return unit_hash_mix(hash ^ tail);
+    }
+
+    UnitArena& arena;
+    std::size_t interned = 0;
+    std::array<std::uint64_t, CacheSlots> hashes{};
+    std::array<const Interned*, CacheSlots> entries{};
+};
+
+#endif //UNITMAKER_UNIT_PARSER_H
@@ -0,0 +1,195 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_UNIT_REDUCE_H
+#define UNITMAKER_UNIT_REDUCE_H
+
+#include "thread_pool.h"
+#include "units.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __has_include(<execution>)
+#include <execution>
+#endif
+
+// Sums over buffers of units, run serially or across threads. The buffer is cut into chunks of unit_reduce_chunk
+// elements whatever the number of threads, each chunk is summed pairwise and the chunk sums are added pairwise in
+// order, so the result is the same bits on one thread or many and its rounding error grows with the logarithm of the
+// length rather than the length. The unit of the result is the unit of what is summed: unit_dot of Watt and Second
+// is an energy.
+
+inline constexpr std::size_t unit_reduce_chunk = std::size_t{1} << 14;
+
+// how a reduction runs: a std::execution policy, serial for seq and unseq and on default_thread_pool() otherwise, or a
+// ThreadPool of one's own
+template<typename E>
+concept UnitExecution = std::is_same_v<std::remove_cvref_t<E>, ThreadPool>
+#ifdef __cpp_lib_execution
+        || std::is_execution_policy_v<std::remove_cvref_t<E>>
+#endif
+        ;
+
+template<UnitExecution E>
+ThreadPool* execution_pool(E& execution) {
+    using policy_t = std::remove_cvref_t<E>;
+    if constexpr (std::is_same_v<policy_t, ThreadPool>) {
+        return &execution;
+#ifdef __cpp_lib_execution
+    } else if constexpr (std::is_same_v<policy_t, std::execution::sequenced_policy>) {
+        return nullptr;
+#if __cpp_lib_execution >= 201902L
+    } else if constexpr (std::is_same_v<policy_t, std::execution::unsequenced_policy>) {
+        return nullptr;
+#endif
+#endif
+    } else {
+        return &default_thread_pool();
+    }
+}
+
+// the number a sum of T adds up: its value for units, T itself otherwise
+template<typename T>
+struct SummedNumeric {
+    using type = T;
+};
+
+template<UnitType T>
+struct SummedNumeric<T> {
+    using type = decltype(T::value);
+};
+
+// the sum of load(i) over [first, last): eight running sums per block of up to 128 elements, and the blocks added in
+// halves, the same pairwise scheme as NumPy's sum
+template<typename T, typename Load>
+T pairwise_sum(std::size_t first, std::size_t last, const Load& load) {
+    constexpr std::size_t block = 128;
+    constexpr std::size_t lanes = 8;
+    if (last - first > block) {
+        const std::size_t middle = first + (last - first) / (2 * block) * block;
+        const std::size_t split = middle == first ? first + block : middle;
+        return pairwise_sum<T>(first, split, load) + pairwise_sum<T>(split, last, load);
+    }
+    T sums[lanes]{};
+    std::size_t i = first;
+    for (; last - i >= lanes; i += lanes) {
+        for (std::size_t j = 0; j < lanes; j++) {
+            sums[j] += load(i + j);
+        }
+    }
+    for (std::size_t j = 0; i < last && j < lanes; i++, j++) {
+        sums[j] += load(i);
+    }
+    return ((sums[0] + sums[1]) + (sums[2] + sums[3])) + ((sums[4] + sums[5]) + (sums[6] + sums[7]));
+}
+
+// pairwise sums of unit_reduce_chunk elements at a time, on pool when there is one, then of the chunk sums
+template<typename T, typename Load>
+T chunked_sum(ThreadPool* pool, std::size_t n, const Load& load) {
+    const std::size_t chunks = (n + unit_reduce_chunk - 1) / unit_reduce_chunk;
+    if (chunks <= 1) {
+        return pairwise_sum<T>(0, n, load);
+    }
+    std::vector<T> partial(chunks);
+    auto sum_chunk = [&](std::size_t c) {
+        partial[c] = pairwise_sum<T>(c * unit_reduce_chunk, std::min(n, (c + 1) * unit_reduce_chunk), load);
+    };
+    if (pool != nullptr && pool->size() > 1) {
+        pool->run(chunks, sum_chunk);
+    } else {
+        for (std::size_t c = 0; c < chunks; c++) {
+            sum_chunk(c);
+        }
+    }
+    return pairwise_sum<T>(0, chunks, [&](std::size_t c) {
+        return partial[c];
+    });
+}
+
+// the sum of transform(values[i]) on pool, or on the calling thread without one
+template<std::ranges::contiguous_range R, typename F>
+auto transform_reduce_on(ThreadPool* pool, const R& values, const F& transform) {
+    using result_t = std::remove_cvref_t<std::invoke_result_t<const F&, const std::ranges::range_value_t<R>&>>;
+    using numeric_t = typename SummedNumeric<result_t>::type;
+    const auto* data = std::ranges::data(values);
+    const numeric_t sum = chunked_sum<numeric_t>(pool, std::ranges::size(values), [&](std::size_t i) {
+        if constexpr (UnitType<result_t>) {
+            return std::invoke(transform, data[i]).value;
+        } else {
+            return std::invoke(transform, data[i]);
+        }
+    });
+    return result_t{sum};
+}
+
+template<std::ranges::contiguous_range A, std::ranges::contiguous_range B, typename F>
+auto transform_reduce_on(ThreadPool* pool, const A& a, const B& b, const F& transform) {
+    using result_t = std::remove_cvref_t<std::invoke_result_t<const F&, const std::ranges::range_value_t<A>&,
+            const std::ranges::range_value_t<B>&>>;
+    using numeric_t = typename SummedNumeric<result_t>::type;
+    assert(std::ranges::size(a) == std::ranges::size(b) && "Reduction of ranges of different lengths");
+    const auto* x = std::ranges::data(a);
+    const auto* y = std::ranges::data(b);
+    const numeric_t sum = chunked_sum<numeric_t>(pool, std::ranges::size(a), [&](std::size_t i) {
+        if constexpr (UnitType<result_t>) {
+            return std::invoke(transform, x[i], y[i]).value;
+        } else {
+            return std::invoke(transform, x[i], y[i]);
+        }
+    });
+    return result_t{sum};
+}
+
+// the sum of transform(values[i]), of the unit or number transform returns
+template<UnitExecution E, std::ranges::contiguous_range R, typename F>
+requires std::invocable<const F&, const std::ranges::range_value_t<R>&>
+auto unit_transform_reduce(E&& execution, const R& values, F transform) {
+    return transform_reduce_on(execution_pool(execution), values, transform);
+}
+
+// the sum of transform(a[i], b[i]) over two ranges of the same length
+template<UnitExecution E, std::ranges::contiguous_range A, std::ranges::contiguous_range B, typename F>
+requires std::invocable<const F&, const std::ranges::range_value_t<A>&, const std::ranges::range_value_t<B>&>
+auto unit_transform_reduce(E&& execution, const A& a, const B& b, F transform) {
+    return transform_reduce_on(execution_pool(execution), a, b, transform);
+}
+
+// the sum of the units in values, eg. the Joule of a day of readings
+template<UnitExecution E, std::ranges::contiguous_range R>
+requires UnitType<std::ranges::range_value_t<R>>
+std::ranges::range_value_t<R> unit_reduce(E&& execution, const R& values) {
+    return transform_reduce_on(execution_pool(execution), values, std::identity{});
+}
+
+template<std::ranges::contiguous_range R>
+requires UnitType<std::ranges::range_value_t<R>>
+std::ranges::range_value_t<R> unit_reduce(const R& values) {
+    return transform_reduce_on(nullptr, values, std::identity{});
+}
+
+// the sum of a[i] * b[i] in the unit of the product, eg. Watt samples and the Second each lasted give the energy
+inline constexpr auto unit_product = [](const auto& x, const auto& y) {
+    return x * y;
+};
+
+template<UnitExecution E, std::ranges::contiguous_range A, std::ranges::contiguous_range B>
+requires requires(const std::ranges::range_value_t<A>& x, const std::ranges::range_value_t<B>& y) { x * y; }
+auto unit_dot(E&& execution, const A& a, const B& b) {
+    return transform_reduce_on(execution_pool(execution), a, b, unit_product);
+}
+
+template<std::ranges::contiguous_range A, std::ranges::contiguous_range B>
+requires requires(const std::ranges::range_value_t<A>& x, const std::ranges::range_value_t<B>& y) { x * y; }
+auto unit_dot(const A& a, const B& b) {
+    return transform_reduce_on(nullptr, a, b, unit_product);
+}
+
+#endif //UNITMAKER_UNIT_REDUCE_H
@@ -0,0 +1,208 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_UNIT_RING_H
+#define UNITMAKER_UNIT_RING_H
+
+#include "unit_atomic.h"
+#include "units.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// A ring of samples passed from one producer thread to one consumer thread, eg. from acquisition to processing. A row
+// is one unit of each column, UnitRing<Volt> holding readings and UnitRing<Second, Volt> timestamped readings, and each
+// column is stored in an array of its own, so the rows ready to read are contiguous units that convert_n and the other
+// buffer kernels can run on in place. Every call finishes in a bounded number of steps whatever the other thread is
+// doing. The producer's and the consumer's positions are on separate cache lines, each next to the copy of the other's
+// position its thread last saw, so neither reads the other's line until its copy says the ring is full or empty.
+
+// rows of a UnitRing, one span per column, that are contiguous in the ring
+template<typename... Columns>
+struct UnitRingSlice {
+    std::size_t rows = 0;
+    std::tuple<Columns*...> data;
+
+    template<std::size_t I = 0>
+    std::span<std::tuple_element_t<I, std::tuple<Columns...>>> column() const {
+        return {std::get<I>(data), rows};
+    }
+};
+
+template<UnitType... Columns>
+requires (sizeof...(Columns) > 0)
+class UnitRing {
+public:
+    using slice_type = UnitRingSlice<Columns...>;
+    using const_slice_type = UnitRingSlice<const Columns...>;
+
+    // capacity is rounded up to a power of two
+    explicit UnitRing(std::size_t capacity)
+            : rows{std::bit_ceil(std::max<std::size_t>(capacity, 1))}, buffers{std::vector<Columns>(rows, Columns{0})...} {}
+
+    UnitRing(const UnitRing&) = delete;
+    UnitRing& operator=(const UnitRing&) = delete;
+
+    std::size_t capacity() const {
+        return rows;
+    }
+
+    // the rows waiting to be read, as seen from either thread at some moment during the call
+    std::size_t size() const {
+        const std::size_t read = consumer.head.load(std::memory_order_acquire);
+        return producer.tail.load(std::memory_order_acquire) - read;
+    }
+
+    // producer: one row, false when the ring is full
+    bool push(const Columns&... values) {
+        const std::size_t tail = producer.tail.load(std::memory_order_relaxed);
+        if (free_rows(tail, 1) == 0) {
+            return false;
+        }
+        const std::size_t at = tail & (rows - 1);
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            ((std::get<I>(buffers)[at] = values), ...);
+        }(std::index_sequence_for<Columns...>{});
+        producer.tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // producer: as many leading rows of the columns as fit, returns how many
+    std::size_t push(std::span<const Columns>... values) {
+        const std::size_t n = std::get<0>(std::tuple{values.size()...});
+        assert(((values.size() == n) && ...) && "UnitRing columns of different lengths");
+        const std::size_t tail = producer.tail.load(std::memory_order_relaxed);
+        const std::size_t count = std::min(n, free_rows(tail, n));
+        const std::size_t at = tail & (rows - 1);
+        const std::size_t first = std::min(count, rows - at);
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            (copy_in<I>(values, at, first, count), ...);
+        }(std::index_sequence_for<Columns...>{});
+        producer.tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    // producer: the free rows up to the end of the ring's arrays, to be written in place and then published
+    slice_type writable() {
+        const std::size_t tail = producer.tail.load(std::memory_order_relaxed);
+        const std::size_t at = tail & (rows - 1);
+        return [&]<std::size_t... I>(std::index_sequence<I...>) {
+            return slice_type{std::min(free_rows(tail, rows - at), rows - at), {std::get<I>(buffers).data() + at...}};
+        }(std::index_sequence_for<Columns...>{});
+    }
+
+    // producer: makes the first count rows of the last writable() readable
+    void publish(std::size_t count) {
+        const std::size_t tail = producer.tail.load(std::memory_order_relaxed);
+        assert(count <= rows - (tail - producer.cached_head) && "UnitRing published more rows than were writable");
+        producer.tail.store(tail + count, std::memory_order_release);
+    }
+
+    // consumer: the oldest row, false when the ring is empty
+    bool pop(Columns&... values) {
+        const std::size_t head = consumer.head.load(std::memory_order_relaxed);
+        if (ready_rows(head, 1) == 0) {
+            return false;
+        }
+        const std::size_t at = head & (rows - 1);
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            ((values = std::get<I>(buffers)[at]), ...);
+        }(std::index_sequence_for<Columns...>{});
+        consumer.head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer: the oldest rows, as many as are ready and fit, returns how many
+    std::size_t pop(std::span<Columns>... values) {
+        const std::size_t n = std::get<0>(std::tuple{values.size()...});
+        assert(((values.size() == n) && ...) && "UnitRing columns of different lengths");
+        const std::size_t head = consumer.head.load(std::memory_order_relaxed);
+        const std::size_t count = std::min(n, ready_rows(head, n));
+        const std::size_t at = head & (rows - 1);
+        const std::size_t first = std::min(count, rows - at);
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            (copy_out<I>(values, at, first, count), ...);
+        }(std::index_sequence_for<Columns...>{});
+        consumer.head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    // consumer: the rows ready up to the end of the ring's arrays, to be read in place and then consumed
+    const_slice_type readable() {
+        const std::size_t head = consumer.head.load(std::memory_order_relaxed);
+        const std::size_t at = head & (rows - 1);
+        return [&]<std::size_t... I>(std::index_sequence<I...>) {
+            return const_slice_type{std::min(ready_rows(head, rows - at), rows - at),
+                    {std::as_const(std::get<I>(buffers)).data() + at...}};
+        }(std::index_sequence_for<Columns...>{});
+    }
+
+    // consumer: frees the first count rows of the last readable() for the producer
+    void consume(std::size_t count) {
+        const std::size_t head = consumer.head.load(std::memory_order_relaxed);
+        assert(count <= consumer.cached_tail - head && "UnitRing consumed more rows than were readable");
+        consumer.head.store(head + count, std::memory_order_release);
+    }
+
+private:
+    // written by the producer only; cached_head is the consumer's position when it last looked
+    struct alignas(unit_cache_line) Producer {
+        std::atomic<std::size_t> tail{0};
+        std::size_t cached_head = 0;
+    };
+
+    struct alignas(unit_cache_line) Consumer {
+        std::atomic<std::size_t> head{0};
+        std::size_t cached_tail = 0;
+    };
+
+    // read by both threads and never written after construction
+    std::size_t rows;
+    std::tuple<std::vector<Columns>...> buffers;
+    Producer producer;
+    Consumer consumer;
+
+    // free rows after tail, looking at the consumer's position again only when fewer than wanted were free before
+    std::size_t free_rows(std::size_t tail, std::size_t wanted) {
+        std::size_t free = rows - (tail - producer.cached_head);
+        if (free < wanted) {
+            producer.cached_head = consumer.head.load(std::memory_order_acquire);
+            free = rows - (tail - producer.cached_head);
+        }
+        return free;
+    }
+
+    std::size_t ready_rows(std::size_t head, std::size_t wanted) {
+        std::size_t ready = consumer.cached_tail - head;
+        if (ready < wanted) {
+            consumer.cached_tail = producer.tail.load(std::memory_order_acquire);
+            ready = consumer.cached_tail - head;
+        }
+        return ready;
+    }
+
+    // count rows into the ring at at, the first of them up to the end of its array and the rest from its start
+    template<std::size_t I, typename T>
+    void copy_in(std::span<const T> values, std::size_t at, std::size_t first, std::size_t count) {
+        std::vector<T>& buffer = std::get<I>(buffers);
+        std::copy_n(values.data(), first, buffer.data() + at);
+        std::copy_n(values.data() + first, count - first, buffer.data());
+    }
+
+    template<std::size_t I, typename T>
+    void copy_out(std::span<T> values, std::size_t at, std::size_t first, std::size_t count) const {
+        const std::vector<T>& buffer = std::get<I>(buffers);
+        std::copy_n(buffer.data() + at, first, values.data());
+        std::copy_n(buffer.data(), count - first, values.data() + first);
+    }
+};
+
+#endif //UNITMAKER_UNIT_RING_H
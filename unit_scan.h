@@ -0,0 +1,374 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_UNIT_SCAN_H
+#define UNITMAKER_UNIT_SCAN_H
+
+#include "unit_convert.h"
+#include "unit_kernels.h"
+#include "unit_parser.h"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+// Lines of "number unit" text, eg. "12.5 ft", "300 psi" or "4.2e3 N", read into quantities of one target unit. Line
+// breaks are found 64 bytes at a time, numbers take an exact fast path before falling back to std::from_chars, and the
+// suffix of each line is looked up in unit_symbols.h (any other unit string through parse_unit) once and then answered
+// from a small cache, so a log with a handful of units costs the numbers and little else. A line whose unit is unknown
+// or of another dimension is reported and skipped, the batch carries on.
+
+enum class UnitScanError {
+    NONE, NUMBER, UNKNOWN_UNIT, DIMENSION_MISMATCH
+};
+
+struct UnitScanIssue {
+    // counted from 0 over every text given to the scanner, blank lines included
+    std::size_t line;
+    UnitScanError error;
+};
+
+struct UnitScanResult {
+    // written to the front of the output, in the order of their lines
+    std::size_t values = 0;
+    // lines skipped, including those that did not fit the issue span
+    std::size_t issues = 0;
+    // bytes of the text read, short of its size when the output filled up; always the start of a line
+    std::size_t consumed = 0;
+};
+
+// bit i of masks[b] is set when text[64 * b + i] is '\n', eight bytes at a time with the exact zero-byte test
+UNITMAKER_SIMD_DISPATCH inline void line_break_masks(const char* text, std::size_t blocks, std::uint64_t* masks) {
+    constexpr std::uint64_t newlines = 0x0a0a0a0a0a0a0a0a;
+    constexpr std::uint64_t low_bits = 0x7f7f7f7f7f7f7f7f;
+    for (std::size_t b = 0; b < blocks; b++) {
+        std::uint64_t mask = 0;
+        for (int w = 0; w < 8; w++) {
+            std::uint64_t v;
+            std::memcpy(&v, text + 64 * b + 8 * w, 8);
+            v ^= newlines;
+            // 0x80 in every byte that was '\n', gathered into 8 bits by the multiply
+            const std::uint64_t zero = ~(((v & low_bits) + low_bits) | v | low_bits);
+            mask |= (((zero >> 7) * 0x0102040810204080) >> 56) << (8 * w);
+        }
+        masks[b] = mask;
+    }
+}
+
+// the powers of ten a double holds exactly
+inline constexpr double exact_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+inline constexpr std::uint64_t exact_powers_of_ten_u64[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000
+};
+
+// how many of the 8 bytes in v, first byte lowest, are ASCII digits before the first that is not; a borrow or carry
+// only starts at a non-digit byte and only moves up, so the lowest flagged byte is exact
+inline int digit_run(std::uint64_t v) {
+    const std::uint64_t not_digit = ((v + 0x4646464646464646) | (v - 0x3030303030303030)) & 0x8080808080808080;
+    return std::countr_zero(not_digit) / 8;
+}
+
+// the value of the first n digits of v, 0 < n <= 8: their bytes are moved to the top so that the ones shifted in are
+// leading zeros, then pairs, fours and eights of digits are combined in parallel
+inline std::uint64_t digits_value(std::uint64_t v, int n) {
+    v = (v - 0x3030303030303030) << (8 * (8 - n));
+    v = v * 10 + (v >> 8);
+    return (((v & 0x000000ff000000ff) * (100 + (std::uint64_t{1000000} << 32)))
+            + (((v >> 16) & 0x000000ff000000ff) * (1 + (std::uint64_t{10000} << 32)))) >> 32;
+}
+
+// appends the run of digits at p to mantissa, 8 at a time while 8 bytes can be read before readable, and returns
+// the end of the run; digits past 19 are counted but leave mantissa to the caller's fallback
+inline const char* scan_digits(const char* p, const char* last, const char* readable, std::uint64_t& mantissa, int& count) {
+    while (readable - p >= 8) {
+        std::uint64_t v;
+        std::memcpy(&v, p, 8);
+        const int n = std::min<std::ptrdiff_t>(digit_run(v), last - p);
+        if (n > 0 && count + n <= 19) {
+            mantissa = mantissa * exact_powers_of_ten_u64[n] + digits_value(v, n);
+        }
+        count += n;
+        p += n;
+        if (n < 8) {
+            return p;
+        }
+    }
+    for (; p != last && static_cast<unsigned char>(*p - '0') < 10; p++) {
+        mantissa = count < 19 ? mantissa * 10 + (*p - '0') : mantissa;
+        count++;
+    }
+    return p;
+}
+
+// a decimal number at the start of [first, last), correctly rounded: when its digits fit 2^53 and its exponent is
+// within the exact powers of ten the value is one multiplication or division, anything else goes to std::from_chars.
+// Bytes up to readable, which is at least last, may be read but are never part of the number.
+inline std::from_chars_result scan_number(const char* first, const char* last, double& value, const char* readable = nullptr) {
+    readable = readable == nullptr ? last : readable;
+    const char* p = first;
+    const bool negative = p != last && *p == '-';
+    p += p != last && (*p == '-' || *p == '+');
+    std::uint64_t mantissa = 0;
+    int count = 0;
+    p = scan_digits(p, last, readable, mantissa, count);
+    int exponent = 0;
+    if (p != last && *p == '.') {
+        const int integer_digits = count;
+        p = scan_digits(p + 1, last, readable, mantissa, count);
+        exponent = integer_digits - count;
+    }
+    if (p != last && (*p == 'e' || *p == 'E')) {
+        const char* e = p + 1;
+        const bool negative_exponent = e != last && *e == '-';
+        e += e != last && (*e == '-' || *e == '+');
+        if (e != last && static_cast<unsigned char>(*e - '0') < 10) {
+            int written = 0;
+            for (; e != last && static_cast<unsigned char>(*e - '0') < 10; e++) {
+                written = written < 10000 ? written * 10 + (*e - '0') : written;
+            }
+            exponent += negative_exponent ? -written : written;
+            p = e;
+        }
+    }
+    if (count > 0 && count <= 19 && mantissa <= std::uint64_t{1} << 53 && exponent >= -22 && exponent <= 22) {
+        const double m = static_cast<double>(mantissa);
+        value = exponent < 0 ? m / exact_powers_of_ten[-exponent] : m * exact_powers_of_ten[exponent];
+        value = negative ? -value : value;
+        return {p, std::errc{}};
+    }
+    // long mantissas, large exponents, inf and nan; std::from_chars reads no '+', which is skipped here unless a sign
+    // follows it, as in "+-5"
+    const char* start = first + (first != last && *first == '+');
+    if (start != first && start != last && *start == '-') {
+        return {first, std::errc::invalid_argument};
+    }
+    const std::from_chars_result result = std::from_chars(start, last, value);
+    return result.ptr == start ? std::from_chars_result{first, std::errc::invalid_argument} : result;
+}
+
+template<typename T>
+struct UnitScanTarget {
+    using unit_type = T;
+    static constexpr double offset = 0.0;
+};
+
+template<UnitOffsetType T>
+struct UnitScanTarget<T> {
+    using unit_type = typename UnitOffsetTraits<T>::unit_type;
+    static constexpr double offset = static_cast<double>(UnitOffsetTraits<T>::offset::num) / UnitOffsetTraits<T>::offset::den;
+};
+
+// how a value written in unit, any string parse_unit reads, becomes a Target value: v * scale + shift
+template<typename Target>
+requires UnitType<Target> || UnitOffsetType<Target>
+UnitScanError find_unit_scale(std::string_view unit, double& scale, double& shift) {
+    using unit_type = typename UnitScanTarget<Target>::unit_type;
+    dimension_t dimension;
+    double factor;
+    double offset;
+    if (const UnitSymbol* symbol = find_unit_symbol(unit)) {
+        dimension = symbol->dimension;
+        factor = symbol->factor;
+        offset = static_cast<double>(symbol->offset_num) / static_cast<double>(symbol->offset_den);
+    } else if (const UnitParseResult parsed = parse_unit(unit)) {
+        dimension = parsed.unit.dimension;
+        factor = parsed.unit.factor;
+        offset = parsed.unit.offset();
+    } else {
+        return UnitScanError::UNKNOWN_UNIT;
+    }
+    if (dimension != unit_type::base_type::packed) {
+        return UnitScanError::DIMENSION_MISMATCH;
+    }
+    // (v + offset) * factor base units, then back out through the target's ratio and offset
+    constexpr double target_factor = rounded_quotient(unit_type::ratio::num, unit_type::ratio::den);
+    scale = factor / target_factor;
+    shift = offset * scale - UnitScanTarget<Target>::offset;
+    return UnitScanError::NONE;
+}
+
+// v in Target's numeric type, integers rounded to the nearest
+template<typename Target>
+decltype(Target::value) unit_scan_value(double v) {
+    return unit_numeric_from_double<decltype(Target::value)>(v);
+}
+
+// reads lines into Target units, keeping the line count and the suffixes it has resolved from one text to the next
+template<typename Target>
+requires UnitType<Target> || UnitOffsetType<Target>
+class UnitScanner {
+public:
+    using value_type = decltype(Target::value);
+
+    // every complete line of text, the last one may lack its '\n'
+    UnitScanResult scan(std::string_view text, std::span<Target> out, std::span<UnitScanIssue> issues = {}) {
+        UnitScanResult result;
+        const char* const begin = text.data();
+        const char* const end = begin + text.size();
+        const char* line = begin;
+        std::uint64_t masks[block_masks];
+        for (std::size_t chunk = 0; chunk < text.size(); chunk += 64 * block_masks) {
+            const std::size_t blocks = std::min<std::size_t>(block_masks, (text.size() - chunk) / 64);
+            line_break_masks(begin + chunk, blocks, masks);
+            // the bytes after the last whole block are searched directly
+            const char* tail = begin + chunk + 64 * blocks;
+            for (std::size_t b = 0; b < blocks; b++) {
+                for (std::uint64_t mask = masks[b]; mask != 0; mask &= mask - 1) {
+                    const char* line_end = begin + chunk + 64 * b + std::countr_zero(mask);
+                    if (!scan_line(line, line_end, end, out, issues, result)) {
+                        result.consumed = line - begin;
+                        return result;
+                    }
+                    line = line_end + 1;
+                }
+            }
+            if (blocks < block_masks) {
+                for (const char* p = tail; p != end; p++) {
+                    if (*p == '\n') {
+                        if (!scan_line(line, p, end, out, issues, result)) {
+                            result.consumed = line - begin;
+                            return result;
+                        }
+                        line = p + 1;
+                    }
+                }
+                break;
+            }
+        }
+        if (line != end && !scan_line(line, end, end, out, issues, result)) {
+            result.consumed = line - begin;
+            return result;
+        }
+        result.consumed = text.size();
+        return result;
+    }
+
+    // lines seen so far, over every call of scan
+    std::size_t lines() const {
+        return line_count;
+    }
+
+private:
+    // line breaks are found for this many 64-byte blocks at a time
+    static constexpr std::size_t block_masks = 64;
+    static constexpr std::size_t cache_slots = 16;
+
+    // how values written with one suffix become target values
+    struct Suffix {
+        // the first 8 bytes as one word, zero past the end, which decides most comparisons on its own
+        std::uint64_t head = 0;
+        char text[unit_symbol_max_length]{};
+        // an empty slot matches nothing, not even an empty suffix
+        std::size_t length = static_cast<std::size_t>(-1);
+        UnitScanError error = UnitScanError::NONE;
+        double scale = 1.0;
+        double shift = 0.0;
+
+        bool matches(std::uint64_t h, const char* s, std::size_t n) const {
+            return n == length && h == head && (n <= 8 || std::memcmp(s + 8, text + 8, n - 8) == 0);
+        }
+    };
+
+    Suffix cache[cache_slots];
+    // suffixes longer than a symbol are resolved on every line into here
+    Suffix uncached;
+    std::size_t line_count = 0;
+
+    static bool is_blank(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    static std::uint64_t suffix_head(const char* s, std::size_t n, const char* readable) {
+        std::uint64_t head = 0;
+        if (readable - s >= 8) {
+            std::memcpy(&head, s, 8);
+            return n >= 8 ? head : head & ((std::uint64_t{1} << (8 * n)) - 1);
+        }
+        std::memcpy(&head, s, std::min<std::size_t>(n, 8));
+        return head;
+    }
+
+    static Suffix resolve(std::uint64_t head, const char* s, std::size_t n) {
+        Suffix suffix;
+        suffix.head = head;
+        std::memcpy(suffix.text, s, std::min(n, unit_symbol_max_length));
+        suffix.length = n;
+        suffix.error = find_unit_scale<Target>({s, n}, suffix.scale, suffix.shift);
+        return suffix;
+    }
+
+    const Suffix& find_suffix(const char* s, std::size_t n, const char* readable) {
+        const std::uint64_t head = suffix_head(s, n, readable);
+        if (n > unit_symbol_max_length) {
+            uncached = resolve(head, s, n);
+            return uncached;
+        }
+        Suffix& slot = cache[(head + n) * 0x9e3779b97f4a7c15 >> (64 - std::countr_zero(cache_slots))];
+        if (!slot.matches(head, s, n)) {
+            slot = resolve(head, s, n);
+        }
+        return slot;
+    }
+
+    // false when out is full, the line is left for the next call
+    bool scan_line(const char* first, const char* last_char, const char* readable, std::span<Target> out, std::span<UnitScanIssue> issues,
+                   UnitScanResult& result) {
+        while (first != last_char && is_blank(*first)) {
+            first++;
+        }
+        while (last_char != first && is_blank(last_char[-1])) {
+            last_char--;
+        }
+        if (first == last_char) {
+            line_count++;
+            return true;
+        }
+        if (result.values == out.size()) {
+            return false;
+        }
+        double v;
+        const std::from_chars_result number = scan_number(first, last_char, v, readable);
+        UnitScanError error = UnitScanError::NUMBER;
+        if (number.ec == std::errc{}) {
+            const char* s = number.ptr;
+            while (s != last_char && is_blank(*s)) {
+                s++;
+            }
+            const Suffix& suffix = find_suffix(s, last_char - s, readable);
+            error = suffix.error;
+            if (error == UnitScanError::NONE) {
+                out[result.values++] = Target{unit_scan_value<Target>(v * suffix.scale + suffix.shift)};
+            }
+        }
+        if (error != UnitScanError::NONE) {
+            if (result.issues < issues.size()) {
+                issues[result.issues] = {line_count, error};
+            }
+            result.issues++;
+        }
+        line_count++;
+        return true;
+    }
+};
+
+// every line of text into out, see UnitScanner
+template<typename Target>
+requires UnitType<Target> || UnitOffsetType<Target>
+UnitScanResult scan_units(std::string_view text, std::span<Target> out, std::span<UnitScanIssue> issues = {}) {
+    UnitScanner<Target> scanner;
+    return scanner.scan(text, out, issues);
+}
+
+#endif //UNITMAKER_UNIT_SCAN_H
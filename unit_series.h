@@ -0,0 +1,468 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_UNIT_SERIES_H
+#define UNITMAKER_UNIT_SERIES_H
+
+#include "mapped_file.h"
+#include "si_units.h"
+#include "unit_columns.h"
+#include "unit_convert.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+// An append-only store of (Second, U) samples in a directory of memory-mapped files. Samples go into segment files of
+// a fixed number of rows, each holding a sparse index of every unit_series_index_stride-th time, the times and the
+// values as separate columns. Every rollup level, one file per bucket width, keeps the min, max, sum and count of each
+// bucket and is updated with every append, so a query over months reads a few thousand buckets instead of the
+// samples. Queries return any unit of U's dimension.
+
+inline constexpr std::size_t unit_series_index_stride = 1024;
+inline constexpr double unit_series_rollup_widths[] = {60.0, 3600.0, 86400.0};
+
+enum class UnitSeriesError {
+    NONE, OPEN, FORMAT, UNIT_MISMATCH, OUT_OF_ORDER, WRITE
+};
+
+struct UnitSeriesFileHeader {
+    char magic[8];
+    std::uint32_t version;
+    // 0x01020304 as the writer stored it
+    std::uint32_t byte_order;
+    // records the file has room for, and records written
+    std::uint64_t capacity;
+    std::uint64_t rows;
+    // for segments, the samples between entries of the time index; for rollups, the bucket width in seconds and the
+    // samples folded into the buckets
+    std::uint64_t stride;
+    double width;
+    std::uint64_t samples;
+    std::uint64_t reserved;
+    UnitColumnHeader unit;
+};
+
+static_assert(sizeof(UnitSeriesFileHeader) == 192 && std::is_trivially_copyable_v<UnitSeriesFileHeader>);
+
+inline constexpr char unit_segment_magic[8] = {'U', 'N', 'I', 'T', 'S', 'E', 'G', 'S'};
+inline constexpr char unit_rollup_magic[8] = {'U', 'N', 'I', 'T', 'R', 'O', 'L', 'L'};
+inline constexpr std::uint32_t unit_series_version = 1;
+
+// a rollup bucket as stored, in the values of the stored unit
+struct UnitRollupBucket {
+    double start;
+    double min;
+    double max;
+    double sum;
+    std::uint64_t count;
+
+    void add(const UnitRollupBucket& b) {
+        min = std::min(min, b.min);
+        max = std::max(max, b.max);
+        sum += b.sum;
+        count += b.count;
+    }
+};
+
+static_assert(std::is_trivially_copyable_v<UnitRollupBucket>);
+
+// a rollup bucket as queried, in any unit of the stored dimension
+template<UnitType V>
+struct UnitRollup {
+    Second start;
+    V min;
+    V max;
+    V mean;
+    std::uint64_t count;
+};
+
+template<UnitType U>
+requires ValueLayoutUnit<U>
+class UnitSeries {
+public:
+    using value_type = decltype(U::value);
+
+    // the series in directory, created if it does not exist; rollup levels whose file is missing, of another width or
+    // behind the segments are rebuilt from the samples
+    explicit UnitSeries(const std::filesystem::path& directory,
+            std::span<const double> rollup_widths = unit_series_rollup_widths, std::size_t segment_rows = 1 << 20)
+            : directory{directory}, segment_rows{std::max<std::size_t>(segment_rows, 1)} {
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        for (std::size_t i = 0; status == UnitSeriesError::NONE && std::filesystem::exists(file_path("segment", i)); i++) {
+            open_segment(i, 0);
+        }
+        for (std::size_t i = 0; i < rollup_widths.size() && status == UnitSeriesError::NONE; i++) {
+            assert(rollup_widths[i] > 0 && (i == 0 || rollup_widths[i] > rollup_widths[i - 1]) && "Rollup widths must increase");
+            open_rollup(i, rollup_widths[i]);
+        }
+    }
+
+    UnitSeriesError error() const {
+        return status;
+    }
+
+    explicit operator bool() const {
+        return status == UnitSeriesError::NONE;
+    }
+
+    std::size_t size() const {
+        return total;
+    }
+
+    // a sample no earlier than the last, OUT_OF_ORDER otherwise
+    UnitSeriesError append(Second time, U value) {
+        if (status != UnitSeriesError::NONE) {
+            return status;
+        }
+        if (total != 0 && time.value < last_time) {
+            return UnitSeriesError::OUT_OF_ORDER;
+        }
+        if (segments.empty() || segments.back().rows == segments.back().capacity) {
+            open_segment(segments.size(), segment_rows);
+            if (status != UnitSeriesError::NONE) {
+                return status;
+            }
+        }
+        Segment& s = segments.back();
+        if (s.rows % s.stride == 0) {
+            s.index[s.rows / s.stride] = time.value;
+        }
+        s.times[s.rows] = time;
+        s.values[s.rows] = value;
+        s.rows++;
+        set_rows(s.file, s.rows);
+        total++;
+        last_time = time.value;
+        const UnitRollupBucket sample{time.value, stored(value), stored(value), stored(value), 1};
+        for (Rollup& r : rollups) {
+            if (!fold(r, sample)) {
+                return status = UnitSeriesError::WRITE;
+            }
+        }
+        return UnitSeriesError::NONE;
+    }
+
+    UnitSeriesError append(std::span<const Second> times, std::span<const U> values) {
+        assert(times.size() == values.size() && "Every sample needs a time and a value");
+        for (std::size_t i = 0; i < times.size(); i++) {
+            if (const UnitSeriesError e = append(times[i], values[i]); e != UnitSeriesError::NONE) {
+                return e;
+            }
+        }
+        return UnitSeriesError::NONE;
+    }
+
+    // on_samples(std::span<const Second>, std::span<const V>) for the samples in [from, to), a run at a time; stored as
+    // V, the spans are the mapped files, otherwise values converted into a buffer
+    template<UnitType V = U, typename F>
+    requires EquivalentBaseType<U, V>
+    void scan(Second from, Second to, F on_samples) const {
+        constexpr std::size_t run = 4096;
+        std::vector<V> converted;
+        for (const Segment& s : segments) {
+            if (s.rows == 0 || s.times[s.rows - 1].value < from.value || s.times[0].value >= to.value) {
+                continue;
+            }
+            const std::size_t first = lower_bound(s, from.value);
+            const std::size_t last = lower_bound(s, to.value);
+            if constexpr (std::is_same_v<V, U>) {
+                if (first != last) {
+                    on_samples(std::span<const Second>{s.times + first, last - first}, std::span<const V>{s.values + first, last - first});
+                }
+            } else {
+                converted.resize(std::min(run, last - first), V{0});
+                for (std::size_t i = first; i < last; i += run) {
+                    const std::size_t n = std::min(run, last - i);
+                    convert_n(s.values + i, n, converted.data());
+                    on_samples(std::span<const Second>{s.times + i, n}, std::span<const V>{converted.data(), n});
+                }
+            }
+        }
+    }
+
+    // min, max, mean and count of the samples in [from, to) per bucket of width seconds, aligned to multiples of width;
+    // buckets without samples are left out. Whole buckets of the coarsest rollup level dividing width are read in
+    // place of their samples.
+    template<UnitType V = U>
+    requires EquivalentBaseType<U, V>
+    std::vector<UnitRollup<V>> rollup(Second from, Second to, Second width) const {
+        assert(width.value > 0 && "Rollup buckets need a width");
+        std::vector<UnitRollupBucket> buckets;
+        auto add = [&](const UnitRollupBucket& b) {
+            const double start = std::floor(b.start / width.value) * width.value;
+            if (!buckets.empty() && buckets.back().start == start) {
+                buckets.back().add(b);
+            } else {
+                buckets.push_back(b);
+                buckets.back().start = start;
+            }
+        };
+        auto add_samples = [&](double first, double last) {
+            scan(Second{first}, Second{last}, [&](std::span<const Second> times, std::span<const U> values) {
+                for (std::size_t i = 0; i < times.size(); i++) {
+                    const double v = stored(values[i]);
+                    add({times[i].value, v, v, v, 1});
+                }
+            });
+        };
+        const Rollup* level = nullptr;
+        for (const Rollup& r : rollups) {
+            if (r.width <= width.value && std::fmod(width.value, r.width) == 0) {
+                level = &r;
+            }
+        }
+        const double aligned_from = level == nullptr ? to.value : std::ceil(from.value / level->width) * level->width;
+        const double aligned_to = level == nullptr ? to.value : std::floor(to.value / level->width) * level->width;
+        if (aligned_from >= aligned_to) {
+            add_samples(from.value, to.value);
+        } else {
+            add_samples(from.value, aligned_from);
+            const UnitRollupBucket* first = std::lower_bound(level->buckets, level->buckets + level->rows, aligned_from,
+                    [](const UnitRollupBucket& b, double t) { return b.start < t; });
+            for (const UnitRollupBucket* b = first; b != level->buckets + level->rows && b->start < aligned_to; b++) {
+                add(*b);
+            }
+            add_samples(aligned_to, to.value);
+        }
+        constexpr double factor = ConversionFactor<typename U::ratio, typename V::ratio>::value;
+        std::vector<UnitRollup<V>> result;
+        result.reserve(buckets.size());
+        for (const UnitRollupBucket& b : buckets) {
+            result.push_back({Second{b.start}, queried<V>(b.min * factor), queried<V>(b.max * factor),
+                    queried<V>(b.sum / static_cast<double>(b.count) * factor), b.count});
+        }
+        return result;
+    }
+
+    // waits for everything appended to reach the files
+    bool sync() const {
+        bool synced = true;
+        for (const Segment& s : segments) {
+            synced = s.file.sync() && synced;
+        }
+        for (const Rollup& r : rollups) {
+            synced = r.file.sync() && synced;
+        }
+        return synced;
+    }
+
+private:
+    struct Segment {
+        WritableMappedFile file;
+        std::size_t capacity;
+        std::size_t stride;
+        std::size_t rows;
+        double* index;
+        Second* times;
+        U* values;
+    };
+
+    struct Rollup {
+        WritableMappedFile file;
+        double width;
+        std::size_t capacity;
+        std::size_t rows;
+        UnitRollupBucket* buckets;
+    };
+
+    std::filesystem::path directory;
+    std::size_t segment_rows;
+    std::vector<Segment> segments;
+    std::vector<Rollup> rollups;
+    std::size_t total = 0;
+    double last_time = 0;
+    UnitSeriesError status = UnitSeriesError::NONE;
+
+    std::filesystem::path file_path(const char* kind, std::size_t i) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%s-%06zu.series", kind, i);
+        return directory / name;
+    }
+
+    static std::size_t aligned(std::size_t offset) {
+        return (offset + unit_column_alignment - 1) / unit_column_alignment * unit_column_alignment;
+    }
+
+    static double stored(U value) {
+        return static_cast<double>(value.value);
+    }
+
+    template<UnitType V>
+    static V queried(double v) {
+        return V{unit_numeric_from_double<decltype(V::value)>(v)};
+    }
+
+    static UnitSeriesFileHeader file_header(const char (&magic)[8], std::size_t capacity) {
+        UnitSeriesFileHeader header{};
+        std::copy(std::begin(magic), std::end(magic), header.magic);
+        header.version = unit_series_version;
+        header.byte_order = 0x01020304;
+        header.capacity = capacity;
+        header.unit = unit_column_header<U>();
+        return header;
+    }
+
+    // a header this series can read, FORMAT or UNIT_MISMATCH otherwise
+    static UnitSeriesError check_header(const WritableMappedFile& file, const char (&magic)[8], UnitSeriesFileHeader& header) {
+        if (file.bytes().size() < sizeof(header)) {
+            return UnitSeriesError::FORMAT;
+        }
+        std::memcpy(&header, file.bytes().data(), sizeof(header));
+        const UnitColumnHeader unit = unit_column_header<U>();
+        if (!std::equal(std::begin(magic), std::end(magic), header.magic) || header.version != unit_series_version
+                || header.byte_order != 0x01020304 || header.rows > header.capacity) {
+            return UnitSeriesError::FORMAT;
+        }
+        const bool same_unit = header.unit.dimension == unit.dimension && header.unit.num == unit.num && header.unit.den == unit.den
+                && header.unit.numeric == unit.numeric && header.unit.fixed == unit.fixed
+                && header.unit.fractional_bits == unit.fractional_bits;
+        return same_unit ? UnitSeriesError::NONE : UnitSeriesError::UNIT_MISMATCH;
+    }
+
+    static void set_rows(const WritableMappedFile& file, std::uint64_t rows) {
+        std::memcpy(file.bytes().data() + offsetof(UnitSeriesFileHeader, rows), &rows, sizeof(rows));
+    }
+
+    // segment i, created with room for capacity rows when it does not exist
+    void open_segment(std::size_t i, std::size_t capacity) {
+        const std::size_t stride = unit_series_index_stride;
+        auto layout = [](std::size_t rows, std::size_t stride, std::size_t (&offsets)[4]) {
+            offsets[0] = aligned(sizeof(UnitSeriesFileHeader));
+            offsets[1] = aligned(offsets[0] + (rows + stride - 1) / stride * sizeof(double));
+            offsets[2] = aligned(offsets[1] + rows * sizeof(Second));
+            offsets[3] = offsets[2] + rows * sizeof(U);
+        };
+        std::size_t offsets[4];
+        layout(capacity, stride, offsets);
+        Segment s{WritableMappedFile{file_path("segment", i).c_str(), capacity == 0 ? 0 : offsets[3]}, 0, 0, 0, nullptr, nullptr, nullptr};
+        UnitSeriesFileHeader header;
+        if (!s.file) {
+            status = UnitSeriesError::OPEN;
+            return;
+        }
+        if (capacity != 0) {
+            header = file_header(unit_segment_magic, capacity);
+            header.stride = stride;
+            std::memcpy(s.file.bytes().data(), &header, sizeof(header));
+        } else if ((status = check_header(s.file, unit_segment_magic, header)) != UnitSeriesError::NONE) {
+            return;
+        }
+        layout(header.capacity, header.stride, offsets);
+        // only the last segment may have room left
+        if (header.stride == 0 || s.file.bytes().size() < offsets[3]
+                || (!segments.empty() && segments.back().rows != segments.back().capacity)) {
+            status = UnitSeriesError::FORMAT;
+            return;
+        }
+        std::byte* base = s.file.bytes().data();
+        s.capacity = header.capacity;
+        s.stride = header.stride;
+        s.rows = header.rows;
+        s.index = std::launder(reinterpret_cast<double*>(base + offsets[0]));
+        s.times = std::launder(reinterpret_cast<Second*>(base + offsets[1]));
+        s.values = std::launder(reinterpret_cast<U*>(base + offsets[2]));
+        if (s.rows != 0) {
+            if (total != 0 && s.times[0].value < last_time) {
+                status = UnitSeriesError::FORMAT;
+                return;
+            }
+            last_time = s.times[s.rows - 1].value;
+        }
+        total += s.rows;
+        segments.push_back(std::move(s));
+    }
+
+    // level i of the given width, rebuilt from the segments unless it already covers every sample
+    void open_rollup(std::size_t i, double width) {
+        constexpr std::size_t initial_capacity = 1024;
+        Rollup r{WritableMappedFile{file_path("rollup", i).c_str(), 0}, width, 0, 0, nullptr};
+        if (!r.file) {
+            status = UnitSeriesError::OPEN;
+            return;
+        }
+        UnitSeriesFileHeader header;
+        const UnitSeriesError e = check_header(r.file, unit_rollup_magic, header);
+        const std::size_t room = r.file.bytes().size() < sizeof(header) ? 0
+                : (r.file.bytes().size() - aligned(sizeof(header))) / sizeof(UnitRollupBucket);
+        if (e != UnitSeriesError::NONE || header.width != width || header.samples != total || header.capacity > room) {
+            // out of date, so folded again from the start
+            if (!r.file.resize(aligned(sizeof(header)) + initial_capacity * sizeof(UnitRollupBucket))) {
+                status = UnitSeriesError::WRITE;
+                return;
+            }
+            header = file_header(unit_rollup_magic, initial_capacity);
+            header.width = width;
+            std::memcpy(r.file.bytes().data(), &header, sizeof(header));
+            attach(r, header);
+            for (const Segment& s : segments) {
+                for (std::size_t j = 0; j < s.rows; j++) {
+                    const double v = stored(s.values[j]);
+                    if (!fold(r, {s.times[j].value, v, v, v, 1})) {
+                        status = UnitSeriesError::WRITE;
+                        return;
+                    }
+                }
+            }
+        } else {
+            attach(r, header);
+        }
+        rollups.push_back(std::move(r));
+    }
+
+    static void attach(Rollup& r, const UnitSeriesFileHeader& header) {
+        r.capacity = header.capacity;
+        r.rows = header.rows;
+        r.buckets = std::launder(reinterpret_cast<UnitRollupBucket*>(r.file.bytes().data() + aligned(sizeof(header))));
+    }
+
+    // the sample or bucket b into the last bucket of r, or a new one after it
+    static bool fold(Rollup& r, const UnitRollupBucket& b) {
+        const double start = std::floor(b.start / r.width) * r.width;
+        if (r.rows != 0 && r.buckets[r.rows - 1].start == start) {
+            r.buckets[r.rows - 1].add(b);
+        } else {
+            if (r.rows == r.capacity) {
+                if (!r.file.resize(aligned(sizeof(UnitSeriesFileHeader)) + 2 * r.capacity * sizeof(UnitRollupBucket))) {
+                    return false;
+                }
+                r.capacity *= 2;
+                std::memcpy(r.file.bytes().data() + offsetof(UnitSeriesFileHeader, capacity), &r.capacity, sizeof(std::uint64_t));
+                r.buckets = std::launder(reinterpret_cast<UnitRollupBucket*>(r.file.bytes().data() + aligned(sizeof(UnitSeriesFileHeader))));
+            }
+            r.buckets[r.rows] = b;
+            r.buckets[r.rows].start = start;
+            r.rows++;
+            set_rows(r.file, r.rows);
+        }
+        std::uint64_t samples;
+        std::memcpy(&samples, r.file.bytes().data() + offsetof(UnitSeriesFileHeader, samples), sizeof(samples));
+        samples += b.count;
+        std::memcpy(r.file.bytes().data() + offsetof(UnitSeriesFileHeader, samples), &samples, sizeof(samples));
+        return true;
+    }
+
+    // the first row of s at or after t, through the sparse index and then one stride of times
+    static std::size_t lower_bound(const Segment& s, double t) {
+        const std::size_t entries = (s.rows + s.stride - 1) / s.stride;
+        const std::size_t block = std::lower_bound(s.index, s.index + entries, t) - s.index;
+        const std::size_t first = block == 0 ? 0 : (block - 1) * s.stride;
+        const std::size_t last = std::min(block * s.stride, s.rows);
+        return std::lower_bound(s.times + first, s.times + last, t, [](const Second& a, double b) {
+            return a.value < b;
+        }) - s.times;
+    }
+};
+
+#endif //UNITMAKER_UNIT_SERIES_H
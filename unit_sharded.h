@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_UNIT_SHARDED_H
+#define UNITMAKER_UNIT_SHARDED_H
+
+#include "unit_atomic.h"
+#include "units.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+// A unit total that many threads add to at once, eg. the Watt*Second of every worker. Each thread adds to its own
+// shard, an AtomicUnit on a cache line of its own, so additions neither wait for one another nor move a cache line
+// between cores; reading the total adds up the shards. Threads are given shards in the order they first add to any
+// ShardedUnit, and only share one when there are more threads than shards.
+
+// the calling thread's number, from 0 in the order threads first ask
+inline std::size_t unit_thread_index() {
+    static std::atomic<std::size_t> next{0};
+    thread_local const std::size_t index = next.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+template<UnitType U>
+class ShardedUnit {
+public:
+    using unit_type = U;
+
+    // shards is rounded up to a power of two, one per hardware thread by default
+    explicit ShardedUnit(std::size_t shards = std::thread::hardware_concurrency())
+            : count{std::bit_ceil(std::max<std::size_t>(shards, 1))}, shards{std::make_unique<Shard[]>(count)} {}
+
+    ShardedUnit(const ShardedUnit&) = delete;
+    ShardedUnit& operator=(const ShardedUnit&) = delete;
+
+    std::size_t size() const {
+        return count;
+    }
+
+    template<UnitType V>
+    requires EquivalentBaseType<U, V>
+    ShardedUnit& operator+=(const V& x) {
+        shard().value.fetch_add(x, std::memory_order_relaxed);
+        return *this;
+    }
+
+    template<UnitType V>
+    requires EquivalentBaseType<U, V>
+    ShardedUnit& operator-=(const V& x) {
+        shard().value.fetch_sub(x, std::memory_order_relaxed);
+        return *this;
+    }
+
+    // the sum of the shards; additions made while it is read may or may not be in it
+    U total() const {
+        U sum{0};
+        for (std::size_t i = 0; i < count; i++) {
+            sum = sum + shards[i].value.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+    // the total, leaving every shard at zero, without losing additions made meanwhile to the next total
+    U take() {
+        U sum{0};
+        for (std::size_t i = 0; i < count; i++) {
+            sum = sum + shards[i].value.exchange(U{0}, std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+private:
+    struct alignas(unit_cache_line) Shard {
+        AtomicUnit<U> value;
+    };
+
+    std::size_t count;
+    std::unique_ptr<Shard[]> shards;
+
+    Shard& shard() {
+        return shards[unit_thread_index() & (count - 1)];
+    }
+};
+
+#endif //UNITMAKER_UNIT_SHARDED_H
@@ -0,0 +1,345 @@
+//
+// Copyright (c) 2020 Jack Vandergriff.
+//
+
+#ifndef UNITMAKER_UNIT_SYMBOLS_H
+#define UNITMAKER_UNIT_SYMBOLS_H
+
+#include "si_units.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <string_view>
+
+// The names a unit may be written with in a unit string: the usual symbols ("N", "lbf", "mmHg"), the alias names of
+// si_units.h ("Newton", "PSI") and every prefix from Milli to Tera on the symbols that take one ("kN", "mm", "GHz").
+// Every symbol carries the exact ratio of its si_units.h type, and lookup goes through a perfect hash built at compile
+// time, so resolving any string is one hash, one probe and one compare.
+
+inline constexpr std::size_t unit_symbol_max_length = 16;
+
+struct UnitSymbol {
+    char text[unit_symbol_max_length];
+    std::uint8_t length;
+    bool prefixable;
+    // the symbol a unit of this dimension, ratio and offset is written with, the first one wins
+    bool preferred;
+    dimension_t dimension;
+    // base units per unit, num / den exactly and factor rounded
+    std::intmax_t num;
+    std::intmax_t den;
+    double factor;
+    // added to a value in this unit before scaling it, nonzero for Celsius and Fahrenheit only
+    std::intmax_t offset_num;
+    std::intmax_t offset_den;
+
+    constexpr std::string_view name() const {
+        return {text, length};
+    }
+
+    constexpr bool has_offset() const {
+        return offset_num != 0;
+    }
+};
+
+template<typename U>
+constexpr UnitSymbol make_unit_symbol(std::string_view text, bool prefixable = false, bool preferred = true) {
+    assert(text.size() <= unit_symbol_max_length && "Unit symbol too long");
+    UnitSymbol symbol{};
+    std::copy(text.begin(), text.end(), symbol.text);
+    symbol.length = static_cast<std::uint8_t>(text.size());
+    symbol.prefixable = prefixable;
+    symbol.preferred = preferred;
+    symbol.offset_den = 1;
+    if constexpr (UnitOffsetType<U>) {
+        using unit_t = typename UnitOffsetTraits<U>::unit_type;
+        symbol.dimension = unit_t::base_type::packed;
+        symbol.num = unit_t::ratio::num;
+        symbol.den = unit_t::ratio::den;
+        symbol.offset_num = UnitOffsetTraits<U>::offset::num;
+        symbol.offset_den = UnitOffsetTraits<U>::offset::den;
+    } else {
+        symbol.dimension = U::base_type::packed;
+        symbol.num = U::ratio::num;
+        symbol.den = U::ratio::den;
+    }
+    symbol.factor = rounded_quotient(symbol.num, symbol.den);
+    return symbol;
+}
+
+struct UnitPrefix {
+    std::string_view text;
+    std::intmax_t num;
+    std::intmax_t den;
+};
+
+inline constexpr UnitPrefix unit_prefixes[] = {
+    {"m", std::milli::num, std::milli::den},
+    {"c", std::centi::num, std::centi::den},
+    {"d", std::deci::num, std::deci::den},
+    {"da", std::deca::num, std::deca::den},
+    {"h", std::hecto::num, std::hecto::den},
+    {"k", std::kilo::num, std::kilo::den},
+    {"M", std::mega::num, std::mega::den},
+    {"G", std::giga::num, std::giga::den},
+    {"T", std::tera::num, std::tera::den},
+};
+
+inline constexpr UnitSymbol unit_base_symbols[] = {
+    // prefixable where SI allows it, "kg" is "g" with the "k" prefix
+    make_unit_symbol<Gram>("g", true),
+    make_unit_symbol<Meter>("m", true),
+    make_unit_symbol<Second>("s", true),
+    make_unit_symbol<Kelvin>("K", true),
+    make_unit_symbol<Ampere>("A", true),
+    make_unit_symbol<Candela>("cd", true),
+    make_unit_symbol<Hertz>("Hz", true),
+    make_unit_symbol<Newton>("N", true),
+    make_unit_symbol<Pascal>("Pa", true),
+    make_unit_symbol<Joule>("J", true),
+    make_unit_symbol<Watt>("W", true),
+    make_unit_symbol<Coulomb>("C", true),
+    make_unit_symbol<Volt>("V", true),
+    make_unit_symbol<Farad>("F", true),
+    make_unit_symbol<Ohm>("ohm", true),
+    make_unit_symbol<Ohm>("Ω", true, false),
+    make_unit_symbol<Siemens>("S", true),
+    make_unit_symbol<Weber>("Wb", true),
+    make_unit_symbol<Tesla>("T", true),
+    make_unit_symbol<Henry>("H", true),
+    make_unit_symbol<Lux>("lx", true),
+    make_unit_symbol<Becquerel>("Bq", true, false),
+    make_unit_symbol<Gray>("Gy", true, false),
+    make_unit_symbol<Sievert>("Sv", true, false),
+    make_unit_symbol<Liter>("L", true),
+    make_unit_symbol<Liter>("l", true, false),
+    make_unit_symbol<Tonne>("t", true),
+    make_unit_symbol<Minute>("min"),
+    make_unit_symbol<Hour>("h"),
+    make_unit_symbol<Day>("d"),
+    make_unit_symbol<AstronomicalUnit>("au"),
+    make_unit_symbol<Hectare>("ha"),
+    make_unit_symbol<Foot>("ft"),
+    make_unit_symbol<Yard>("yd"),
+    make_unit_symbol<Mile>("mi"),
+    make_unit_symbol<Inch>("in"),
+    make_unit_symbol<Slug>("slug"),
+    make_unit_symbol<Pound>("lbf"),
+    make_unit_symbol<Kip>("kip"),
+    make_unit_symbol<PSI>("psi"),
+    make_unit_symbol<Atmosphere>("atm"),
+    make_unit_symbol<mmHg>("mmHg"),
+    make_unit_symbol<mph>("mph"),
+    make_unit_symbol<Rankine>("degR", false, false),
+    make_unit_symbol<Rankine>("°R"),
+    make_unit_symbol<Celsius>("degC", false, false),
+    make_unit_symbol<Celsius>("°C"),
+    make_unit_symbol<Fahrenheit>("degF", false, false),
+    make_unit_symbol<Fahrenheit>("°F"),
+};
+
+// the alias names of si_units.h, never preferred, the ones that are also symbols are listed above
+inline constexpr UnitSymbol unit_alias_symbols[] = {
+    make_unit_symbol<Kilogram>("Kilogram"),
+    make_unit_symbol<Meter>("Meter"),
+    make_unit_symbol<Second>("Second"),
+    make_unit_symbol<Kelvin>("Kelvin"),
+    make_unit_symbol<Ampere>("Ampere"),
+    make_unit_symbol<Candela>("Candela"),
+    make_unit_symbol<Hertz>("Hertz"),
+    make_unit_symbol<Newton>("Newton"),
+    make_unit_symbol<Pascal>("Pascal"),
+    make_unit_symbol<Joule>("Joule"),
+    make_unit_symbol<Watt>("Watt"),
+    make_unit_symbol<Coulomb>("Coulomb"),
+    make_unit_symbol<Volt>("Volt"),
+    make_unit_symbol<Farad>("Farad"),
+    make_unit_symbol<Ohm>("Ohm"),
+    make_unit_symbol<Siemens>("Siemens"),
+    make_unit_symbol<Weber>("Weber"),
+    make_unit_symbol<Tesla>("Tesla"),
+    make_unit_symbol<Henry>("Henry"),
+    make_unit_symbol<Lux>("Lux"),
+    make_unit_symbol<Becquerel>("Becquerel"),
+    make_unit_symbol<Gray>("Gray"),
+    make_unit_symbol<Sievert>("Sievert"),
+    make_unit_symbol<Minute>("Minute"),
+    make_unit_symbol<Hour>("Hour"),
+    make_unit_symbol<Day>("Day"),
+    make_unit_symbol<AstronomicalUnit>("AstronomicalUnit"),
+    make_unit_symbol<Hectare>("Hectare"),
+    make_unit_symbol<Liter>("Liter"),
+    make_unit_symbol<Litre>("Litre"),
+    make_unit_symbol<Tonne>("Tonne"),
+    make_unit_symbol<MetricTon>("MetricTon"),
+    make_unit_symbol<Foot>("Foot"),
+    make_unit_symbol<Yard>("Yard"),
+    make_unit_symbol<Mile>("Mile"),
+    make_unit_symbol<Inch>("Inch"),
+    make_unit_symbol<Slug>("Slug"),
+    make_unit_symbol<Pound>("Pound"),
+    make_unit_symbol<Kip>("Kip"),
+    make_unit_symbol<FootPound>("FootPound"),
+    make_unit_symbol<PSI>("PSI"),
+    make_unit_symbol<Gram>("Gram"),
+    make_unit_symbol<Atmosphere>("Atmosphere"),
+    make_unit_symbol<Torr>("Torr"),
+    make_unit_symbol<mps>("mps"),
+    make_unit_symbol<Rankine>("Rankine"),
+    make_unit_symbol<Celsius>("Celsius"),
+    make_unit_symbol<Fahrenheit>("Fahrenheit"),
+};
+
+constexpr std::size_t count_unit_symbols() {
+    std::size_t count = std::size(unit_base_symbols) + std::size(unit_alias_symbols);
+    for (const UnitSymbol& symbol : unit_base_symbols) {
+        count += symbol.prefixable ? std::size(unit_prefixes) : 0;
+    }
+    return count;
+}
+
+constexpr UnitSymbol prefix_unit_symbol(const UnitPrefix& prefix, const UnitSymbol& symbol) {
+    UnitSymbol prefixed = symbol;
+    std::copy(prefix.text.begin(), prefix.text.end(), prefixed.text);
+    std::copy(symbol.name().begin(), symbol.name().end(), prefixed.text + prefix.text.size());
+    prefixed.length = static_cast<std::uint8_t>(prefix.text.size() + symbol.length);
+    prefixed.prefixable = false;
+    const std::intmax_t num_gcd = std::gcd(prefix.num, symbol.den);
+    const std::intmax_t den_gcd = std::gcd(prefix.den, symbol.num);
+    prefixed.num = (prefix.num / num_gcd) * (symbol.num / den_gcd);
+    prefixed.den = (prefix.den / den_gcd) * (symbol.den / num_gcd);
+    prefixed.factor = rounded_quotient(prefixed.num, prefixed.den);
+    return prefixed;
+}
+
+constexpr auto build_unit_symbols() {
+    std::array<UnitSymbol, count_unit_symbols()> symbols{};
+    std::size_t n = 0;
+    // every plain symbol ahead of the prefixed ones, so a preferred "t" wins over "Mg"
+    for (const UnitSymbol& symbol : unit_base_symbols) {
+        symbols[n++] = symbol;
+    }
+    for (const UnitSymbol& symbol : unit_base_symbols) {
+        for (std::size_t p = 0; symbol.prefixable && p < std::size(unit_prefixes); p++) {
+            symbols[n++] = prefix_unit_symbol(unit_prefixes[p], symbol);
+        }
+    }
+    for (const UnitSymbol& symbol : unit_alias_symbols) {
+        symbols[n++] = symbol;
+        symbols[n - 1].preferred = false;
+    }
+    return symbols;
+}
+
+inline constexpr auto unit_symbols = build_unit_symbols();
+
+// FNV-1a
+constexpr std::uint64_t unit_symbol_hash(std::string_view text) {
+    std::uint64_t hash = 0xcbf29ce484222325;
+    for (char c : text) {
+        hash = (hash ^ static_cast<std::uint8_t>(c)) * 0x100000001b3;
+    }
+    return hash;
+}
+
+constexpr std::uint64_t unit_hash_mix(std::uint64_t x) {
+    x = (x ^ (x >> 33)) * 0xff51afd7ed558ccd;
+    x = (x ^ (x >> 33)) * 0xc4ceb9fe1a85ec53;
+    return x ^ (x >> 33);
+}
+
+// Hash and displace: symbols are grouped into buckets by their hash, and each bucket gets the first seed that sends
+// all of its symbols to slots no other symbol holds, so every symbol has a slot to itself and a miss is a single probe
+template<std::size_t N>
+struct UnitSymbolIndex {
+    static constexpr std::size_t slots = std::bit_ceil(2 * N);
+    static constexpr std::size_t buckets = N / 2 + 1;
+
+    std::array<std::uint16_t, buckets> seeds{};
+    // index into the symbol table plus one, zero for an empty slot
+    std::array<std::uint16_t, slots> entries{};
+    bool perfect = true;
+
+    constexpr std::size_t slot(std::uint64_t hash) const {
+        return static_cast<std::size_t>(unit_hash_mix(hash + seeds[bucket(hash)] * 0x9e3779b97f4a7c15) & (slots - 1));
+    }
+
+    static constexpr std::size_t bucket(std::uint64_t hash) {
+        return static_cast<std::size_t>((hash >> 32) % buckets);
+    }
+};
+
+template<std::size_t N>
+constexpr UnitSymbolIndex<N> build_unit_symbol_index(const std::array<UnitSymbol, N>& symbols) {
+    using index_t = UnitSymbolIndex<N>;
+    index_t index{};
+    std::array<std::uint64_t, N> hashes{};
+    std::array<std::size_t, index_t::buckets + 1> starts{};
+    for (std::size_t i = 0; i < N; i++) {
+        hashes[i] = unit_symbol_hash(symbols[i].name());
+        starts[index_t::bucket(hashes[i]) + 1]++;
+    }
+    for (std::size_t b = 0; b < index_t::buckets; b++) {
+        starts[b + 1] += starts[b];
+    }
+    std::array<std::size_t, N> members{};
+    std::array<std::size_t, index_t::buckets> filled{};
+    for (std::size_t i = 0; i < N; i++) {
+        const std::size_t b = index_t::bucket(hashes[i]);
+        members[starts[b] + filled[b]++] = i;
+    }
+
+    // the largest buckets are placed first, while the table is at its emptiest
+    std::array<std::size_t, index_t::buckets> order{};
+    for (std::size_t b = 0; b < index_t::buckets; b++) {
+        order[b] = b;
+    }
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return filled[a] > filled[b];
+    });
+
+    std::array<std::size_t, N> trial{};
+    for (std::size_t b : order) {
+        const std::size_t begin = starts[b];
+        const std::size_t end = starts[b + 1];
+        bool placed = begin == end;
+        for (std::uint32_t seed = 0; !placed; seed++) {
+            // symbols that are spelled the same collide under every seed
+            if (seed > UINT16_MAX) {
+                index.perfect = false;
+                return index;
+            }
+            index.seeds[b] = static_cast<std::uint16_t>(seed);
+            placed = true;
+            for (std::size_t m = begin; placed && m < end; m++) {
+                trial[m] = index.slot(hashes[members[m]]);
+                placed = index.entries[trial[m]] == 0 && std::find(&trial[begin], &trial[m], trial[m]) == &trial[m];
+            }
+        }
+        for (std::size_t m = begin; m < end; m++) {
+            index.entries[trial[m]] = static_cast<std::uint16_t>(members[m] + 1);
+        }
+    }
+    return index;
+}
+
+inline constexpr auto unit_symbol_index = build_unit_symbol_index(unit_symbols);
+static_assert(unit_symbol_index.perfect, "Every unit symbol must be spelled differently");
+
+// the symbol spelled exactly text, or nullptr
+constexpr const UnitSymbol* find_unit_symbol(std::string_view text) {
+    if (text.size() > unit_symbol_max_length) {
+        return nullptr;
+    }
+    const std::uint16_t entry = unit_symbol_index.entries[unit_symbol_index.slot(unit_symbol_hash(text))];
+    if (entry == 0 || unit_symbols[entry - 1].name() != text) {
+        return nullptr;
+    }
+    return &unit_symbols[entry - 1];
+}
+
+#endif //UNITMAKER_UNIT_SYMBOLS_H
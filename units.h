@@ -5,9 +5,14 @@
 #ifndef UNITMAKER_UNITS_H
 #define UNITMAKER_UNITS_H
 
-#define UNIT_SET_RATIO(type, numerator, denominator) template<> intmax_t type::ratio::num = ( numerator ); template<> intmax_t type::ratio::den = ( denominator )
-
 #include <ratio>
+#include <limits>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <initializer_list>
 #include <concepts>
 #include <type_traits>
 
@@ -17,21 +22,82 @@ concept RatioType = requires (){
     {T::den} -> std::convertible_to<std::intmax_t>;
 };
 
+enum class BaseTypes {
+    MASS=0, LENGTH=1, TIME=2, TEMPERATURE=3, CURRENT=4, LUMINOUS_INTENSITY=5, CUSTOM_0=6, CUSTOM_1=7
+};
+
+// A dimension packs one signed 8-bit exponent per BaseTypes lane into a single word, eg. m/s^2 is {LENGTH: 1, TIME: -2}
+using dimension_t = std::uint64_t;
+
+inline constexpr int dimension_lanes = 8;
+inline constexpr dimension_t dimension_sign_bits = 0x8080808080808080;
+
+constexpr dimension_t base_dimension(BaseTypes type, int exponent = 1) {
+    return dimension_t{static_cast<std::uint8_t>(exponent)} << (8 * static_cast<int>(type));
+}
+
+constexpr int dimension_exponent(dimension_t dimension, BaseTypes type) {
+    return static_cast<std::int8_t>(static_cast<std::uint8_t>(dimension >> (8 * static_cast<int>(type))));
+}
+
+// lane-wise exponent addition, carries never cross lanes
+constexpr dimension_t dimension_multiply(dimension_t a, dimension_t b) {
+    return ((a & ~dimension_sign_bits) + (b & ~dimension_sign_bits)) ^ ((a ^ b) & dimension_sign_bits);
+}
+
+// lane-wise exponent negation
+constexpr dimension_t dimension_inverse(dimension_t a) {
+    return (dimension_sign_bits - (a & ~dimension_sign_bits)) ^ (~a & dimension_sign_bits);
+}
+
+constexpr bool dimension_multiply_overflows(dimension_t a, dimension_t b) {
+    const dimension_t product = dimension_multiply(a, b);
+    return ((a ^ product) & (b ^ product) & dimension_sign_bits) != 0;
+}
+
+constexpr bool dimension_inverse_overflows(dimension_t a) {
+    return (a & dimension_inverse(a) & dimension_sign_bits) != 0;
+}
+
+template<dimension_t Packed>
+struct Dimension {
+    static constexpr dimension_t packed = Packed;
+
+    static constexpr int exponent(BaseTypes type) {
+        return dimension_exponent(Packed, type);
+    }
+};
+
+template<BaseTypes Type>
+using BaseDimension = Dimension<base_dimension(Type)>;
+
+using Dimensionless = Dimension<0>;
+
+template<typename T>
+concept DimensionType = requires (){
+    {T::packed} -> std::convertible_to<dimension_t>;
+} && std::same_as<T, Dimension<T::packed>>;
+
+template<typename T>
+concept FixedPointType = requires (T t){
+    {T::fractional_bits} -> std::convertible_to<int>;
+    {t.raw} -> std::convertible_to<typename T::rep>;
+} && std::signed_integral<typename T::rep>;
+
+template<typename T>
+concept NumericType = std::is_arithmetic_v<T> || FixedPointType<T>;
+
 template<typename T>
 concept UnitType =
-    RatioType<typename T::base_type> &&
+    DimensionType<typename T::base_type> &&
     RatioType<typename T::ratio> &&
-    std::is_arithmetic_v<decltype(T::value)>;
+    NumericType<decltype(T::value)>;
 
 template<typename T1, typename T2>
 concept EquivalentBaseType =
     UnitType<T1> &&
     UnitType<T2> &&
-    std::ratio_equal_v<typename T1::base_type, typename T2::base_type>;
-
-enum class BaseTypes {
-    MASS=2, LENGTH=3, TIME=5, TEMPERATURE=7, CURRENT=11, LUMINOUS_INTENSITY=13
-};
+    std::same_as<typename T1::base_type, typename T2::base_type>;
 
 template<typename T>
 struct RuntimeRatio {
@@ -50,20 +116,430 @@ struct RecursiveRatioMultiply<std::ratio<1, 1>> {
     using ratio = std::ratio<1, 1>;
 };
 
+template<DimensionType ...Ds>
+struct DimensionProduct {
+private:
+    static constexpr dimension_t factors[] = {Dimensionless::packed, Ds::packed...};
+
+    static constexpr bool overflows() {
+        dimension_t product = Dimensionless::packed;
+        for (dimension_t factor : factors) {
+            if (dimension_multiply_overflows(product, factor)) {
+                return true;
+            }
+            product = dimension_multiply(product, factor);
+        }
+        return false;
+    }
+
+    static constexpr dimension_t multiply() {
+        dimension_t product = Dimensionless::packed;
+        for (dimension_t factor : factors) {
+            product = dimension_multiply(product, factor);
+        }
+        return product;
+    }
+
+    static_assert(!overflows(), "Dimension exponent out of range [-128, 127]");
+public:
+    using type = Dimension<multiply()>;
+};
+
+template<DimensionType D>
+struct DimensionInverse {
+    static_assert(!dimension_inverse_overflows(D::packed), "Dimension exponent out of range [-128, 127]");
+    using type = Dimension<dimension_inverse(D::packed)>;
+};
+
+enum class Rounding {
+    TRUNCATE, NEAREST, FLOOR
+};
+
+#ifdef __SIZEOF_INT128__
+__extension__ using wide_intmax_t = __int128;
+__extension__ using wide_uintmax_t = unsigned __int128;
+#else
+using wide_intmax_t = std::intmax_t;
+using wide_uintmax_t = std::uintmax_t;
+#endif
+
+constexpr int wide_bit_width(wide_uintmax_t value) {
+    int bits = 0;
+    for (; value != 0; value >>= 1) {
+        bits++;
+    }
+    return bits;
+}
+
+// num / den rounded to the nearest double, ties to even
+constexpr double rounded_quotient(wide_uintmax_t num, wide_uintmax_t den) {
+    constexpr wide_uintmax_t exact_limit = wide_uintmax_t{1} << 53;
+    if (num < exact_limit && den < exact_limit) {
+        return static_cast<double>(num) / static_cast<double>(den);
+    }
+
+    // normalize to den <= num < 2 * den, then long divide out the 53 significant bits
+    int exponent = 0;
+    while (num >= 2 * den) {
+        den <<= 1;
+        exponent++;
+    }
+    while (num < den) {
+        num <<= 1;
+        exponent--;
+    }
+    std::uint64_t mantissa = 0;
+    for (int bit = 0; bit < 53; bit++) {
+        mantissa <<= 1;
+        if (num >= den) {
+            mantissa |= 1;
+            num -= den;
+        }
+        num <<= 1;
+    }
+    if (num > den || (num == den && (mantissa & 1))) {
+        mantissa++;
+        if (mantissa == std::uint64_t{1} << 53) {
+            mantissa >>= 1;
+            exponent++;
+        }
+    }
+
+    double result = static_cast<double>(mantissa);
+    for (int e = exponent - 52; e > 0; e--) {
+        result *= 2;
+    }
+    for (int e = exponent - 52; e < 0; e++) {
+        result /= 2;
+    }
+    return result;
+}
+
+// From / To, cross-reduced before multiplying so no intermediate overflows. Factors too large for intmax_t are not
+// exact, and are only usable through value, the correctly rounded double
+template<RatioType From, RatioType To>
+struct ConversionFactor {
+    static_assert(From::num > 0 && From::den > 0 && To::num > 0 && To::den > 0, "Unit ratios must be positive");
+private:
+    static constexpr std::intmax_t num_gcd = std::gcd(From::num, To::num);
+    static constexpr std::intmax_t den_gcd = std::gcd(From::den, To::den);
+public:
+    static constexpr wide_uintmax_t wide_num = static_cast<wide_uintmax_t>(From::num / num_gcd) * static_cast<wide_uintmax_t>(To::den / den_gcd);
+    static constexpr wide_uintmax_t wide_den = static_cast<wide_uintmax_t>(From::den / den_gcd) * static_cast<wide_uintmax_t>(To::num / num_gcd);
+    static_assert(wide_num / static_cast<wide_uintmax_t>(From::num / num_gcd) == static_cast<wide_uintmax_t>(To::den / den_gcd) &&
+                  wide_den / static_cast<wide_uintmax_t>(From::den / den_gcd) == static_cast<wide_uintmax_t>(To::num / num_gcd),
+                  "Conversion factor overflows wide_uintmax_t");
+
+    static constexpr bool exact = wide_num <= INTMAX_MAX && wide_den <= INTMAX_MAX;
+    static constexpr std::intmax_t num = exact ? static_cast<std::intmax_t>(wide_num) : 0;
+    static constexpr std::intmax_t den = exact ? static_cast<std::intmax_t>(wide_den) : 0;
+    static constexpr double value = rounded_quotient(wide_num, wide_den);
+};
+
+// Exact value * Factor for integers. Splitting value into quotient and remainder of Factor::den keeps every division
+// by the compile-time constant den, which compiles to a reciprocal multiply, and keeps the remainder product below
+// num * den, so the wide type is only needed for that product when num * den itself overflows
+template<typename Factor, Rounding Round, std::integral From>
+constexpr wide_intmax_t scale_exact(From value) {
+    static_assert(Factor::exact, "scale_exact requires a factor that fits intmax_t");
+    constexpr std::intmax_t num = Factor::num;
+    constexpr std::intmax_t den = Factor::den;
+    using narrow_t = std::conditional_t<std::is_signed_v<From>, std::intmax_t, std::uintmax_t>;
+
+    if constexpr (den == 1) {
+        return static_cast<wide_intmax_t>(value) * num;
+    } else {
+        using remainder_t = std::conditional_t<(den <= INTMAX_MAX / num), narrow_t, wide_intmax_t>;
+        const narrow_t quotient = static_cast<narrow_t>(value) / den;
+        const remainder_t remainder = static_cast<remainder_t>(static_cast<narrow_t>(value) % den) * num;
+
+        wide_intmax_t result = static_cast<wide_intmax_t>(quotient) * num + static_cast<wide_intmax_t>(remainder / den);
+        const remainder_t rest = remainder % den;
+        if constexpr (Round == Rounding::FLOOR && std::is_signed_v<From>) {
+            result -= rest < 0;
+        } else if constexpr (Round == Rounding::NEAREST) {
+            const remainder_t magnitude = rest < 0 ? -rest : rest;
+            if (magnitude >= den - magnitude) {
+                result += rest < 0 ? -1 : 1;
+            }
+        }
+        return result;
+    }
+}
+
+template<std::integral To, Rounding Round, std::floating_point From>
+constexpr To round_to(From value) {
+    if constexpr (Round == Rounding::NEAREST) {
+        // value - truncated is exact, where value + 0.5 would round 0.49999999999999994 up to 1
+        const To truncated = static_cast<To>(value);
+        const From rest = value - static_cast<From>(truncated);
+        return static_cast<To>(truncated + (rest >= From{0.5}) - (rest <= From{-0.5}));
+    } else if constexpr (Round == Rounding::FLOOR) {
+        const To truncated = static_cast<To>(value);
+        return truncated - (static_cast<From>(truncated) > value);
+    } else {
+        return static_cast<To>(value);
+    }
+}
+
+// Signed fixed-point number stored as raw / 2^FractionalBits, usable as the Numeric of any unit
+template<int FractionalBits, std::signed_integral Rep = std::int32_t>
+requires (FractionalBits >= 0 && FractionalBits < 8 * sizeof(Rep))
+struct Fixed {
+    using rep = Rep;
+    using wide_rep = std::conditional_t<(sizeof(Rep) <= 4), std::int64_t, wide_intmax_t>;
+    static constexpr int fractional_bits = FractionalBits;
+
+    Rep raw;
+
+    constexpr Fixed() = default;
+
+    template<typename T>
+    requires std::is_arithmetic_v<T>
+    constexpr Fixed(T v) : raw{from_value(v)} {}
+
+    // another format rescaled to this one, rounded to the nearest when fractional bits are dropped
+    template<int OtherBits, std::signed_integral OtherRep>
+    explicit constexpr Fixed(Fixed<OtherBits, OtherRep> f) : raw{from_fixed(f)} {}
+
+    static constexpr Fixed from_raw(Rep r) {
+        Fixed f;
+        f.raw = r;
+        return f;
+    }
+
+    template<typename T>
+    requires std::is_arithmetic_v<T>
+    explicit constexpr operator T() const {
+        if constexpr (std::is_floating_point_v<T>) {
+            return static_cast<T>(raw) / static_cast<T>(wide_rep{1} << FractionalBits);
+        } else {
+            return static_cast<T>(raw >> FractionalBits);
+        }
+    }
+
+    friend constexpr Fixed operator+(Fixed a, Fixed b) {
+        return from_raw(narrow(wide_rep{a.raw} + b.raw));
+    }
+
+    friend constexpr Fixed operator-(Fixed a, Fixed b) {
+        return from_raw(narrow(wide_rep{a.raw} - b.raw));
+    }
+
+    friend constexpr Fixed operator-(Fixed a) {
+        return from_raw(narrow(-wide_rep{a.raw}));
+    }
+
+    friend constexpr Fixed operator*(Fixed a, Fixed b) {
+        return from_raw(narrow((wide_rep{a.raw} * b.raw) >> FractionalBits));
+    }
+
+    friend constexpr Fixed operator/(Fixed a, Fixed b) {
+        return from_raw(narrow((wide_rep{a.raw} << FractionalBits) / b.raw));
+    }
+
+    friend constexpr bool operator==(const Fixed&, const Fixed&) = default;
+    friend constexpr auto operator<=>(const Fixed&, const Fixed&) = default;
+
+    // with NDEBUG unset, values that don't fit Rep fail an assert instead of silently wrapping
+    static constexpr Rep narrow(wide_rep value) {
+        assert(value >= std::numeric_limits<Rep>::min() && value <= std::numeric_limits<Rep>::max() && "Fixed overflow");
+        return static_cast<Rep>(value);
+    }
+
+private:
+    template<int OtherBits, typename OtherRep>
+    static constexpr Rep from_fixed(Fixed<OtherBits, OtherRep> f) {
+        using wide_t = std::conditional_t<(sizeof(Rep) <= 4 && sizeof(OtherRep) <= 4), std::int64_t, wide_intmax_t>;
+        wide_t value = f.raw;
+        if constexpr (OtherBits < FractionalBits) {
+            value *= wide_t{1} << (FractionalBits - OtherBits);
+        } else if constexpr (OtherBits > FractionalBits) {
+            value = (value + (wide_t{1} << (OtherBits - FractionalBits - 1))) >> (OtherBits - FractionalBits);
+        }
+        assert(value >= std::numeric_limits<Rep>::min() && value <= std::numeric_limits<Rep>::max() && "Fixed overflow");
+        return static_cast<Rep>(value);
+    }
+
+    template<typename T>
+    static constexpr Rep from_value(T v) {
+        if constexpr (std::is_floating_point_v<T>) {
+            const T scaled = v * static_cast<T>(wide_rep{1} << FractionalBits);
+            return narrow(static_cast<wide_rep>(scaled < 0 ? scaled - T{0.5} : scaled + T{0.5}));
+        } else {
+            return narrow(static_cast<wide_rep>(v) * (wide_rep{1} << FractionalBits));
+        }
+    }
+};
+
+// Two formats meet in the finer one, with the wider of their Reps, so Fixed<16> + Fixed<12> is a Fixed<16>
+template<int A, typename RepA, int B, typename RepB>
+struct std::common_type<Fixed<A, RepA>, Fixed<B, RepB>> {
+    using type = Fixed<(A > B ? A : B), std::conditional_t<(sizeof(RepA) >= sizeof(RepB)), RepA, RepB>>;
+};
+
+template<int A, typename RepA, int B, typename RepB>
+requires (!std::is_same_v<Fixed<A, RepA>, Fixed<B, RepB>>)
+constexpr auto operator+(Fixed<A, RepA> a, Fixed<B, RepB> b) {
+    using common_t = std::common_type_t<Fixed<A, RepA>, Fixed<B, RepB>>;
+    return common_t{a} + common_t{b};
+}
+
+template<int A, typename RepA, int B, typename RepB>
+requires (!std::is_same_v<Fixed<A, RepA>, Fixed<B, RepB>>)
+constexpr auto operator-(Fixed<A, RepA> a, Fixed<B, RepB> b) {
+    using common_t = std::common_type_t<Fixed<A, RepA>, Fixed<B, RepB>>;
+    return common_t{a} - common_t{b};
+}
+
+template<int A, typename RepA, int B, typename RepB>
+requires (!std::is_same_v<Fixed<A, RepA>, Fixed<B, RepB>>)
+constexpr auto operator*(Fixed<A, RepA> a, Fixed<B, RepB> b) {
+    using common_t = std::common_type_t<Fixed<A, RepA>, Fixed<B, RepB>>;
+    return common_t{a} * common_t{b};
+}
+
+template<int A, typename RepA, int B, typename RepB>
+requires (!std::is_same_v<Fixed<A, RepA>, Fixed<B, RepB>>)
+constexpr auto operator/(Fixed<A, RepA> a, Fixed<B, RepB> b) {
+    using common_t = std::common_type_t<Fixed<A, RepA>, Fixed<B, RepB>>;
+    return common_t{a} / common_t{b};
+}
+
+template<int A, typename RepA, int B, typename RepB>
+requires (!std::is_same_v<Fixed<A, RepA>, Fixed<B, RepB>>)
+constexpr bool operator==(Fixed<A, RepA> a, Fixed<B, RepB> b) {
+    using common_t = std::common_type_t<Fixed<A, RepA>, Fixed<B, RepB>>;
+    return common_t{a} == common_t{b};
+}
+
+template<int A, typename RepA, int B, typename RepB>
+requires (!std::is_same_v<Fixed<A, RepA>, Fixed<B, RepB>>)
+constexpr auto operator<=>(Fixed<A, RepA> a, Fixed<B, RepB> b) {
+    using common_t = std::common_type_t<Fixed<A, RepA>, Fixed<B, RepB>>;
+    return common_t{a} <=> common_t{b};
+}
+
+struct FixedMultiplier {
+    wide_uintmax_t multiplier;
+    int shift;
+};
+
+// multiplier / 2^shift ~= num / den * 2^exponent, at the highest precision that keeps multiplier below 2^max_bits
+constexpr FixedMultiplier fixed_multiplier(wide_uintmax_t num, wide_uintmax_t den, int exponent, int max_bits) {
+    constexpr int wide_bits = 8 * sizeof(wide_uintmax_t);
+    const wide_uintmax_t limit = wide_uintmax_t{1} << max_bits;
+    const int num_bits = wide_bit_width(num);
+    const int den_bits = wide_bit_width(den);
+    for (int shift = wide_bits / 2 - 2; shift > 0; shift--) {
+        const int k = exponent + shift;
+        wide_uintmax_t numerator = num;
+        wide_uintmax_t denominator = den;
+        if (k >= 0 && num_bits + k < wide_bits - 1) {
+            numerator <<= k;
+        } else if (k < 0 && den_bits - k < wide_bits - 1) {
+            denominator <<= -k;
+        } else {
+            continue;
+        }
+        const wide_uintmax_t multiplier = (numerator + denominator / 2) / denominator;
+        if (multiplier < limit) {
+            return {multiplier, shift};
+        }
+    }
+    const wide_uintmax_t numerator = num << (exponent > 0 ? exponent : 0);
+    const wide_uintmax_t denominator = den << (exponent < 0 ? -exponent : 0);
+    return {(numerator + denominator / 2) / denominator, 0};
+}
+
+template<typename T>
+struct FixedView {
+    using rep = T;
+    static constexpr int fractional_bits = 0;
+};
+
+template<FixedPointType T>
+struct FixedView<T> {
+    using rep = typename T::rep;
+    static constexpr int fractional_bits = T::fractional_bits;
+};
+
+// value * Factor where either side is fixed-point. Between fixed-point and integral values the ratio and the change in
+// fractional bits fold into a single integer multiply and rounding shift
+template<typename Factor, typename To, typename From>
+constexpr To scale_fixed(From value) {
+    if constexpr (std::is_floating_point_v<From>) {
+        return To(value * Factor::value);
+    } else if constexpr (std::is_floating_point_v<To>) {
+        constexpr To factor = static_cast<To>(Factor::value / static_cast<double>(wide_intmax_t{1} << FixedView<From>::fractional_bits));
+        return static_cast<To>(value.raw) * factor;
+    } else {
+        using from_rep = std::conditional_t<FixedPointType<From>, typename FixedView<From>::rep, std::int64_t>;
+        using to_rep = typename FixedView<To>::rep;
+        using wide_t = std::conditional_t<(sizeof(from_rep) <= 4), std::int64_t, wide_intmax_t>;
+        constexpr int max_bits = 8 * sizeof(wide_t) - 8 * sizeof(from_rep) - 1;
+        constexpr FixedMultiplier m = fixed_multiplier(Factor::wide_num, Factor::wide_den,
+                FixedView<To>::fractional_bits - FixedView<From>::fractional_bits, max_bits);
+
+        wide_t raw;
+        if constexpr (FixedPointType<From>) {
+            raw = value.raw;
+        } else {
+            raw = static_cast<from_rep>(value);
+        }
+        wide_t product = raw * static_cast<wide_t>(m.multiplier);
+        if constexpr (m.shift > 0) {
+            product = (product + (wide_t{1} << (m.shift - 1))) >> m.shift;
+        }
+        assert(product >= std::numeric_limits<to_rep>::min() && product <= std::numeric_limits<to_rep>::max() && "Fixed overflow");
+        if constexpr (FixedPointType<To>) {
+            return To::from_raw(static_cast<to_rep>(product));
+        } else {
+            return static_cast<To>(product);
+        }
+    }
+}
+
+// whether an exact integer result fits To, asserted before narrowing to it
+template<typename To>
+constexpr bool wide_fits(wide_intmax_t value) {
+    if constexpr (std::is_unsigned_v<To>) {
+        return value >= 0 && static_cast<wide_uintmax_t>(value) <= std::numeric_limits<To>::max();
+    } else {
+        return value >= std::numeric_limits<To>::min() && value <= std::numeric_limits<To>::max();
+    }
+}
+
+// value * Factor as To, staying in integer arithmetic whenever both sides are integral and Factor is exact
+template<typename Factor, typename To, Rounding Round = Rounding::TRUNCATE, typename From>
+constexpr To scale_value(From value) {
+    if constexpr (FixedPointType<To> || FixedPointType<From>) {
+        return scale_fixed<Factor, To>(value);
+    } else if constexpr (Factor::num == 1 && Factor::den == 1) {
+        return static_cast<To>(value);
+    } else if constexpr (std::is_integral_v<To> && std::is_integral_v<From> && Factor::exact) {
+        const wide_intmax_t scaled = scale_exact<Factor, Round>(value);
+        assert(wide_fits<To>(scaled) && "Unit conversion overflow");
+        return static_cast<To>(scaled);
+    } else {
+        constexpr double factor = Factor::value;
+        if constexpr (std::is_integral_v<To>) {
+            return round_to<To, Round>(value * factor);
+        } else {
+            return static_cast<To>(value * factor);
+        }
+    }
+}
+
 template<typename T, typename Numeric = double> // can't constrain on UnitType, since type will be incomplete at this point
-requires std::is_arithmetic_v<Numeric>
+requires NumericType<Numeric>
 struct AbstractUnit {
 private:
     template<UnitType To, UnitType From>
     requires EquivalentBaseType<To, From>
     static constexpr To convert(const From& from) {
-        using ratio_t = std::ratio<From::ratio::num * To::ratio::den, From::ratio::den * To::ratio::num>;
-        if constexpr (std::is_integral_v<decltype(To::value)> && ratio_t::den == 1) {
-            return To{static_cast<decltype(To::value)>(from.value * ratio_t::num)};
-        } else {
-            constexpr double ratio = 1.0 * ratio_t::num / ratio_t::den;
-            return To{from.value * ratio};
-        }
+        using factor_t = ConversionFactor<typename From::ratio, typename To::ratio>;
+        return To{scale_value<factor_t, decltype(To::value)>(from.value)};
     }
 
     template<typename To, UnitType From>
@@ -75,7 +551,9 @@ public:
     Numeric value;
     explicit constexpr AbstractUnit(Numeric v) : value{v} {}
 
+    // only to the types convert() takes, so that a type constructible from units, like DynamicUnit, is made one way
     template<typename To>
+    requires requires (const T& unit) { convert<To, T>(unit); }
     constexpr operator To() const {
         return convert<To, T>(static_cast<const T&>(*this));
     }
@@ -86,7 +564,7 @@ template<BaseTypes Type, typename Numeric = double>
 struct Unit : public AbstractUnit<Unit<Type, Numeric>, Numeric> {
     using AbstractUnit<Unit<Type, Numeric>, Numeric>::AbstractUnit;
 
-    using base_type = std::ratio<(int)Type, 1>;
+    using base_type = BaseDimension<Type>;
     using ratio = std::ratio<1, 1>;
 };
 
@@ -102,11 +580,11 @@ template<UnitType ...Ts>
 struct MultiUnit : public AbstractUnit<MultiUnit<Ts...>, std::common_type_t<decltype(Ts::value)...>> {
     using AbstractUnit<MultiUnit<Ts...>, std::common_type_t<decltype(Ts::value)...>>::AbstractUnit;
 
-    using base_type = typename RecursiveRatioMultiply<typename Ts::base_type...>::ratio;
+    using base_type = typename DimensionProduct<typename Ts::base_type...>::type;
     using ratio = typename RecursiveRatioMultiply<typename Ts::ratio...>::ratio;
 };
 
-template<RatioType BaseType, RatioType Ratio=std::ratio<1, 1>, typename Numeric = double>
+template<DimensionType BaseType, RatioType Ratio=std::ratio<1, 1>, typename Numeric = double>
 struct SpecifiedUnit : public AbstractUnit<SpecifiedUnit<BaseType, Ratio, Numeric>, Numeric> {
     using AbstractUnit<SpecifiedUnit<BaseType, Ratio, Numeric>, Numeric>::AbstractUnit;
 
@@ -117,33 +595,15 @@ struct SpecifiedUnit : public AbstractUnit<SpecifiedUnit<BaseType, Ratio, Numeri
 template<UnitType Type, typename Numeric>
 using NumericUnit = SpecifiedUnit<typename Type::base_type, typename Type::ratio, Numeric>;
 
-template<BaseTypes Type, int ID, typename Numeric = double>
-struct RuntimeUnit {
-    Numeric value;
-    explicit constexpr RuntimeUnit(Numeric v): value(v) {}
-
-    template<UnitType T>
-    requires EquivalentBaseType<T, RuntimeUnit<Type, ID>>
-    explicit constexpr RuntimeUnit(T other): value{Unit<Type>{other}.value / ratio::num * ratio::den} {}
-
-    template<UnitType T>
-    requires EquivalentBaseType<RuntimeUnit<Type, ID>, T>
-    constexpr operator T() {
-        return T{Unit<Type>{value * ratio::num / ratio::den}};
-    }
-
-    using base_type = std::ratio<(int) Type, 1>;
-    struct ratio {
-        static inline intmax_t num = 1;
-        static inline intmax_t den = 1;
-    };
-};
+// The single type operators produce for a given (dimension, ratio, Numeric), however the operands were spelled
+template<DimensionType BaseType, RatioType Ratio, typename Numeric>
+using CanonicalUnit = SpecifiedUnit<BaseType, typename std::ratio<Ratio::num, Ratio::den>::type, Numeric>;
 
 template<UnitType T>
 struct UnitInverse : public AbstractUnit<UnitInverse<T>, decltype(T::value)> {
     using AbstractUnit<UnitInverse<T>, decltype(T::value)>::AbstractUnit;
 
-    using base_type = std::ratio_divide<std::ratio<1, 1>, typename T::base_type>;
+    using base_type = typename DimensionInverse<typename T::base_type>::type;
     using ratio = std::ratio_divide<std::ratio<1, 1>, typename T::ratio>;
 };
 
@@ -164,54 +624,94 @@ struct UnitOffset {
     }
 };
 
+template<typename T>
+struct UnitOffsetTraits {};
+
+template<UnitType T, RatioType Offset, typename Numeric>
+struct UnitOffsetTraits<UnitOffset<T, Offset, Numeric>> {
+    using unit_type = T;
+    using offset = Offset;
+};
+
+template<typename T>
+concept UnitOffsetType = UnitType<typename UnitOffsetTraits<T>::unit_type>;
+
+template<UnitType To, Rounding Round = Rounding::TRUNCATE, UnitType From>
+requires EquivalentBaseType<To, From>
+constexpr To unit_cast(const From& from) {
+    using factor_t = ConversionFactor<typename From::ratio, typename To::ratio>;
+    return To{scale_value<factor_t, decltype(To::value), Round>(from.value)};
+}
+
+// Result of T1 + T2 or T1 - T2: T1's ratio, unless both are integral and T2 is not a whole multiple of T1, in which case
+// the finest ratio both convert to exactly, so integer sums never go through floating point. Values at that ratio are
+// larger by up to its denominator, so its Numeric is at least 64 bits wide
+template<UnitType T1, UnitType T2>
+requires EquivalentBaseType<T1, T2>
+struct SumUnit {
+private:
+    using T1_ratio = typename T1::ratio;
+    using T2_ratio = typename T2::ratio;
+    static constexpr bool whole_multiple = ConversionFactor<T2_ratio, T1_ratio>::exact && ConversionFactor<T2_ratio, T1_ratio>::den == 1;
+    static constexpr bool integral = std::is_integral_v<decltype(T1::value)> && std::is_integral_v<decltype(T2::value)>;
+public:
+    using type = std::conditional_t<integral && !whole_multiple,
+            CanonicalUnit<typename T1::base_type,
+                    std::ratio<std::gcd(T1_ratio::num, T2_ratio::num), std::lcm(T1_ratio::den, T2_ratio::den)>,
+                    decltype(T1::value + T2::value + std::int64_t{})>,
+            CanonicalUnit<typename T1::base_type, T1_ratio,
+                    std::conditional_t<whole_multiple, decltype(T1::value + T2::value), decltype(T1::value + 1.0 * T2::value)>>>;
+};
+
 template<UnitType T1, UnitType T2>
-constexpr MultiUnit<T1, T2> operator*(const T1& t1, const T2& t2) {
-    return MultiUnit<T1, T2>{t1.value * t2.value};
+constexpr auto operator*(const T1& t1, const T2& t2) {
+    return CanonicalUnit<typename DimensionProduct<typename T1::base_type, typename T2::base_type>::type,
+            std::ratio_multiply<typename T1::ratio, typename T2::ratio>, decltype(t1.value * t2.value)>{t1.value * t2.value};
 }
 
 template<typename T1, typename T2>
 requires std::is_arithmetic_v<T1> && UnitType<T2>
 constexpr auto operator*(const T1& v, const T2& t) {
-    return SpecifiedUnit<typename T2::base_type, typename T2::ratio, decltype(t.value * v)>{t.value * v};
+    return CanonicalUnit<typename T2::base_type, typename T2::ratio, decltype(t.value * v)>{t.value * v};
 }
 
 template<typename T1, typename T2>
 requires std::is_arithmetic_v<T2> && UnitType<T1>
 constexpr auto operator*(const T1& t, const T2& v) {
-    return SpecifiedUnit<typename T1::base_type, typename T1::ratio, decltype(t.value * v)>{t.value * v};
+    return CanonicalUnit<typename T1::base_type, typename T1::ratio, decltype(t.value * v)>{t.value * v};
 }
 
 template<UnitType T1, UnitType T2>
-constexpr MultiUnit<T1, UnitInverse<T2>> operator/(const T1& t1, const T2& t2) {
-    return MultiUnit<T1, UnitInverse<T2>>{t1.value / t2.value};
+constexpr auto operator/(const T1& t1, const T2& t2) {
+    return CanonicalUnit<typename DimensionProduct<typename T1::base_type, typename DimensionInverse<typename T2::base_type>::type>::type,
+            std::ratio_divide<typename T1::ratio, typename T2::ratio>, decltype(t1.value / t2.value)>{t1.value / t2.value};
 }
 
 template<typename T1, typename T2>
 requires std::is_arithmetic_v<T1> && UnitType<T2>
 constexpr auto operator/(const T1& v, const T2& t) {
-    return UnitInverse<SpecifiedUnit<typename T2::base_type, typename T2::ratio, decltype(v / t.value)>>{v / t.value};
+    return CanonicalUnit<typename DimensionInverse<typename T2::base_type>::type,
+            std::ratio_divide<std::ratio<1, 1>, typename T2::ratio>, decltype(v / t.value)>{v / t.value};
 }
 
 template<typename T1, typename T2>
 requires std::is_arithmetic_v<T2> && UnitType<T1>
 constexpr auto operator/(const T1& t, const T2& v) {
-    return SpecifiedUnit<typename T1::base_type, typename T1::ratio, decltype(t.value / v)>{t.value / v};
+    return CanonicalUnit<typename T1::base_type, typename T1::ratio, decltype(t.value / v)>{t.value / v};
 }
 
 template<UnitType T1, UnitType T2>
 requires EquivalentBaseType<T1, T2>
 constexpr auto operator+(const T1& t1, const T2& t2) {
-    using ret_type = SpecifiedUnit<typename T1::base_type, typename T1::ratio,
-            std::conditional_t<std::ratio_divide<typename T2::ratio, typename T1::ratio>::den == 1, decltype(t1.value + t2.value), decltype(t1.value + 1.0 * t2.value)>>;
-    return ret_type{t1.value + ret_type{t2}.value};
+    using ret_type = typename SumUnit<T1, T2>::type;
+    return ret_type{unit_cast<ret_type>(t1).value + unit_cast<ret_type>(t2).value};
 }
 
 template<UnitType T1, UnitType T2>
 requires EquivalentBaseType<T1, T2>
 constexpr auto operator-(const T1& t1, const T2& t2) {
-    using ret_type = SpecifiedUnit<typename T1::base_type, typename T1::ratio,
-            std::conditional_t<std::ratio_divide<typename T2::ratio, typename T1::ratio>::den == 1, decltype(t1.value - t2.value), decltype(t1.value - 1.0 * t2.value)>>;
-    return ret_type{t1.value - ret_type{t2}.value};
+    using ret_type = typename SumUnit<T1, T2>::type;
+    return ret_type{unit_cast<ret_type>(t1).value - unit_cast<ret_type>(t2).value};
 }
 
 #endif //UNITMAKER_UNITS_H
@@ -5,9 +5,14 @@
 #ifndef UNITMAKER_UNITS_H
 #define UNITMAKER_UNITS_H
 
-#define UNIT_SET_RATIO(type, numerator, denominator) template<> intmax_t type::ratio::num = ( numerator ); template<> intmax_t type::ratio::den = ( denominator )
-
 #include <ratio>
+#include <limits>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <initializer_list>
 #include <concepts>
 #include <type_traits>
 
@@ -21,12 +26,72 @@ struct is_ratio<T, std::void_t<decltype(T::num), decltype(T::den)>> :
 template<typename T>
 inline constexpr bool is_ratio_v = is_ratio<T>::value;
 
+enum class BaseTypes {
+    MASS=0, LENGTH=1, TIME=2, TEMPERATURE=3, CURRENT=4, LUMINOUS_INTENSITY=5, CUSTOM_0=6, CUSTOM_1=7
+};
+
+// A dimension packs one signed 8-bit exponent per BaseTypes lane into a single word, eg. m/s^2 is {LENGTH: 1, TIME: -2}
+using dimension_t = std::uint64_t;
+
+inline constexpr int dimension_lanes = 8;
+inline constexpr dimension_t dimension_sign_bits = 0x8080808080808080;
+
+constexpr dimension_t base_dimension(BaseTypes type, int exponent = 1) {
+    return dimension_t{static_cast<std::uint8_t>(exponent)} << (8 * static_cast<int>(type));
+}
+
+constexpr int dimension_exponent(dimension_t dimension, BaseTypes type) {
+    return static_cast<std::int8_t>(static_cast<std::uint8_t>(dimension >> (8 * static_cast<int>(type))));
+}
+
+// lane-wise exponent addition, carries never cross lanes
+constexpr dimension_t dimension_multiply(dimension_t a, dimension_t b) {
+    return ((a & ~dimension_sign_bits) + (b & ~dimension_sign_bits)) ^ ((a ^ b) & dimension_sign_bits);
+}
+
+// lane-wise exponent negation
+constexpr dimension_t dimension_inverse(dimension_t a) {
+    return (dimension_sign_bits - (a & ~dimension_sign_bits)) ^ (~a & dimension_sign_bits);
+}
+
+constexpr bool dimension_multiply_overflows(dimension_t a, dimension_t b) {
+    const dimension_t product = dimension_multiply(a, b);
+    return ((a ^ product) & (b ^ product) & dimension_sign_bits) != 0;
+}
+
+constexpr bool dimension_inverse_overflows(dimension_t a) {
+    return (a & dimension_inverse(a) & dimension_sign_bits) != 0;
+}
+
+template<dimension_t Packed>
+struct Dimension {
+    static constexpr dimension_t packed = Packed;
+
+    static constexpr int exponent(BaseTypes type) {
+        return dimension_exponent(Packed, type);
+    }
+};
+
+template<BaseTypes Type>
+using BaseDimension = Dimension<base_dimension(Type)>;
+
+using Dimensionless = Dimension<0>;
+
+template<typename, typename = void>
+struct is_dimension : std::false_type {};
+
+template<typename T>
+struct is_dimension<T, std::void_t<decltype(T::packed)>> : std::is_same<T, Dimension<T::packed>> {};
+
+template<typename T>
+inline constexpr bool is_dimension_v = is_dimension<T>::value;
+
 template<typename, typename = void>
 struct is_unit : std::false_type {};
 
 template<typename T>
 struct is_unit<T, std::void_t<typename T::base_type, typename T::ratio, decltype(T::value)>> :
-        std::conjunction<is_ratio<typename T::base_type>, is_ratio<typename T::ratio>, std::is_arithmetic<decltype(T::value)>> {};
+        std::conjunction<is_dimension<typename T::base_type>, is_ratio<typename T::ratio>, std::is_arithmetic<decltype(T::value)>> {};
 
 template<typename T>
 inline constexpr bool is_unit_v = is_unit<T>::value;
@@ -36,15 +101,11 @@ struct has_equivalent_base_type : std::false_type {};
 
 template<typename T1, typename T2>
 struct has_equivalent_base_type<T1, T2, std::enable_if_t<is_unit_v<T1> && is_unit_v<T2>, void>> :
-        std::ratio_equal<typename T1::base_type, typename T2::base_type> {};
+        std::is_same<typename T1::base_type, typename T2::base_type> {};
 
 template<typename T1, typename T2>
 inline constexpr bool has_equivalent_base_type_v = has_equivalent_base_type<T1, T2>::value;
 
-enum class BaseTypes {
-    MASS=2, LENGTH=3, TIME=5, TEMPERATURE=7, CURRENT=11, LUMINOUS_INTENSITY=13
-};
-
 template<typename T>
 struct RuntimeRatio {
     static inline intmax_t num = 1;
@@ -63,6 +124,205 @@ struct RecursiveRatioMultiply<std::ratio<1, 1>> {
     using ratio = std::ratio<1, 1>;
 };
 
+template<typename ...Ds>
+struct DimensionProduct {
+    static_assert(std::conjunction_v<is_dimension<Ds>...>, "DimensionProduct only accepts valid dimensions (see is_dimension<T>)");
+private:
+    static constexpr dimension_t factors[] = {Dimensionless::packed, Ds::packed...};
+
+    static constexpr bool overflows() {
+        dimension_t product = Dimensionless::packed;
+        for (dimension_t factor : factors) {
+            if (dimension_multiply_overflows(product, factor)) {
+                return true;
+            }
+            product = dimension_multiply(product, factor);
+        }
+        return false;
+    }
+
+    static constexpr dimension_t multiply() {
+        dimension_t product = Dimensionless::packed;
+        for (dimension_t factor : factors) {
+            product = dimension_multiply(product, factor);
+        }
+        return product;
+    }
+
+    static_assert(!overflows(), "Dimension exponent out of range [-128, 127]");
+public:
+    using type = Dimension<multiply()>;
+};
+
+template<typename D>
+struct DimensionInverse {
+    static_assert(is_dimension_v<D>, "DimensionInverse must be passed a valid dimension (see is_dimension<T>)");
+    static_assert(!dimension_inverse_overflows(D::packed), "Dimension exponent out of range [-128, 127]");
+    using type = Dimension<dimension_inverse(D::packed)>;
+};
+
+enum class Rounding {
+    TRUNCATE, NEAREST, FLOOR
+};
+
+#ifdef __SIZEOF_INT128__
+__extension__ using wide_intmax_t = __int128;
+__extension__ using wide_uintmax_t = unsigned __int128;
+#else
+using wide_intmax_t = std::intmax_t;
+using wide_uintmax_t = std::uintmax_t;
+#endif
+
+constexpr int wide_bit_width(wide_uintmax_t value) {
+    int bits = 0;
+    for (; value != 0; value >>= 1) {
+        bits++;
+    }
+    return bits;
+}
+
+// num / den rounded to the nearest double, ties to even
+constexpr double rounded_quotient(wide_uintmax_t num, wide_uintmax_t den) {
+    constexpr wide_uintmax_t exact_limit = wide_uintmax_t{1} << 53;
+    if (num < exact_limit && den < exact_limit) {
+        return static_cast<double>(num) / static_cast<double>(den);
+    }
+
+    // normalize to den <= num < 2 * den, then long divide out the 53 significant bits
+    int exponent = 0;
+    while (num >= 2 * den) {
+        den <<= 1;
+        exponent++;
+    }
+    while (num < den) {
+        num <<= 1;
+        exponent--;
+    }
+    std::uint64_t mantissa = 0;
+    for (int bit = 0; bit < 53; bit++) {
+        mantissa <<= 1;
+        if (num >= den) {
+            mantissa |= 1;
+            num -= den;
+        }
+        num <<= 1;
+    }
+    if (num > den || (num == den && (mantissa & 1))) {
+        mantissa++;
+        if (mantissa == std::uint64_t{1} << 53) {
+            mantissa >>= 1;
+            exponent++;
+        }
+    }
+
+    double result = static_cast<double>(mantissa);
+    for (int e = exponent - 52; e > 0; e--) {
+        result *= 2;
+    }
+    for (int e = exponent - 52; e < 0; e++) {
+        result /= 2;
+    }
+    return result;
+}
+
+// From / To, cross-reduced before multiplying so no intermediate overflows. Factors too large for intmax_t are not
+// exact, and are only usable through value, the correctly rounded double
+template<typename From, typename To>
+struct ConversionFactor {
+    static_assert(From::num > 0 && From::den > 0 && To::num > 0 && To::den > 0, "Unit ratios must be positive");
+private:
+    static constexpr std::intmax_t num_gcd = std::gcd(From::num, To::num);
+    static constexpr std::intmax_t den_gcd = std::gcd(From::den, To::den);
+public:
+    static constexpr wide_uintmax_t wide_num = static_cast<wide_uintmax_t>(From::num / num_gcd) * static_cast<wide_uintmax_t>(To::den / den_gcd);
+    static constexpr wide_uintmax_t wide_den = static_cast<wide_uintmax_t>(From::den / den_gcd) * static_cast<wide_uintmax_t>(To::num / num_gcd);
+    static_assert(wide_num / static_cast<wide_uintmax_t>(From::num / num_gcd) == static_cast<wide_uintmax_t>(To::den / den_gcd) &&
+                  wide_den / static_cast<wide_uintmax_t>(From::den / den_gcd) == static_cast<wide_uintmax_t>(To::num / num_gcd),
+                  "Conversion factor overflows wide_uintmax_t");
+
+    static constexpr bool exact = wide_num <= INTMAX_MAX && wide_den <= INTMAX_MAX;
+    static constexpr std::intmax_t num = exact ? static_cast<std::intmax_t>(wide_num) : 0;
+    static constexpr std::intmax_t den = exact ? static_cast<std::intmax_t>(wide_den) : 0;
+    static constexpr double value = rounded_quotient(wide_num, wide_den);
+};
+
+// Exact value * Factor for integers. Splitting value into quotient and remainder of Factor::den keeps every division
+// by the compile-time constant den, which compiles to a reciprocal multiply, and keeps the remainder product below
+// num * den, so the wide type is only needed for that product when num * den itself overflows
+template<typename Factor, Rounding Round, typename From>
+constexpr wide_intmax_t scale_exact(From value) {
+    static_assert(std::is_integral_v<From>, "scale_exact requires an integral type (see std::is_integral<T>)");
+    static_assert(Factor::exact, "scale_exact requires a factor that fits intmax_t");
+    constexpr std::intmax_t num = Factor::num;
+    constexpr std::intmax_t den = Factor::den;
+    using narrow_t = std::conditional_t<std::is_signed_v<From>, std::intmax_t, std::uintmax_t>;
+
+    if constexpr (den == 1) {
+        return static_cast<wide_intmax_t>(value) * num;
+    } else {
+        using remainder_t = std::conditional_t<(den <= INTMAX_MAX / num), narrow_t, wide_intmax_t>;
+        const narrow_t quotient = static_cast<narrow_t>(value) / den;
+        const remainder_t remainder = static_cast<remainder_t>(static_cast<narrow_t>(value) % den) * num;
+
+        wide_intmax_t result = static_cast<wide_intmax_t>(quotient) * num + static_cast<wide_intmax_t>(remainder / den);
+        const remainder_t rest = remainder % den;
+        if constexpr (Round == Rounding::FLOOR && std::is_signed_v<From>) {
+            result -= rest < 0;
+        } else if constexpr (Round == Rounding::NEAREST) {
+            const remainder_t magnitude = rest < 0 ? -rest : rest;
+            if (magnitude >= den - magnitude) {
+                result += rest < 0 ? -1 : 1;
+            }
+        }
+        return result;
+    }
+}
+
+template<typename To, Rounding Round, typename From>
+constexpr To round_to(From value) {
+    static_assert(std::is_integral_v<To> && std::is_floating_point_v<From>, "round_to rounds floating point to integral types");
+    if constexpr (Round == Rounding::NEAREST) {
+        // value - truncated is exact, where value + 0.5 would round 0.49999999999999994 up to 1
+        const To truncated = static_cast<To>(value);
+        const From rest = value - static_cast<From>(truncated);
+        return static_cast<To>(truncated + (rest >= From{0.5}) - (rest <= From{-0.5}));
+    } else if constexpr (Round == Rounding::FLOOR) {
+        const To truncated = static_cast<To>(value);
+        return truncated - (static_cast<From>(truncated) > value);
+    } else {
+        return static_cast<To>(value);
+    }
+}
+
+// whether an exact integer result fits To, asserted before narrowing to it
+template<typename To>
+constexpr bool wide_fits(wide_intmax_t value) {
+    if constexpr (std::is_unsigned_v<To>) {
+        return value >= 0 && static_cast<wide_uintmax_t>(value) <= std::numeric_limits<To>::max();
+    } else {
+        return value >= std::numeric_limits<To>::min() && value <= std::numeric_limits<To>::max();
+    }
+}
+
+// value * Factor as To, staying in integer arithmetic whenever both sides are integral and Factor is exact
+template<typename Factor, typename To, Rounding Round = Rounding::TRUNCATE, typename From>
+constexpr To scale_value(From value) {
+    if constexpr (Factor::num == 1 && Factor::den == 1) {
+        return static_cast<To>(value);
+    } else if constexpr (std::is_integral_v<To> && std::is_integral_v<From> && Factor::exact) {
+        const wide_intmax_t scaled = scale_exact<Factor, Round>(value);
+        assert(wide_fits<To>(scaled) && "Unit conversion overflow");
+        return static_cast<To>(scaled);
+    } else {
+        constexpr double factor = Factor::value;
+        if constexpr (std::is_integral_v<To>) {
+            return round_to<To, Round>(value * factor);
+        } else {
+            return static_cast<To>(value * factor);
+        }
+    }
+}
+
 template<typename T, typename Numeric = double>
 struct AbstractUnit {
     static_assert(std::is_arithmetic_v<Numeric>, "AbstractUnit requires an arithmetic type (see std::is_arithmetic<T>)");
@@ -70,13 +330,8 @@ private:
     template<typename To, typename From, class = typename
             std::enable_if_t<has_equivalent_base_type_v<To, From>>>
     static constexpr To convert(const From& from) {
-        using ratio_t = std::ratio<From::ratio::num * To::ratio::den, From::ratio::den * To::ratio::num>;
-        if constexpr (std::is_integral_v<decltype(To::value)> && ratio_t::den == 1) {
-            return To{static_cast<decltype(To::value)>(from.value * ratio_t::num)};
-        } else {
-            constexpr double ratio = 1.0 * ratio_t::num / ratio_t::den;
-            return To{from.value * ratio};
-        }
+        using factor_t = ConversionFactor<typename From::ratio, typename To::ratio>;
+        return To{scale_value<factor_t, decltype(To::value)>(from.value)};
     }
 
     template<typename To, typename From, class = typename
@@ -99,7 +354,7 @@ template<BaseTypes Type, typename Numeric = double>
 struct Unit : public AbstractUnit<Unit<Type, Numeric>, Numeric> {
     using AbstractUnit<Unit<Type, Numeric>, Numeric>::AbstractUnit;
 
-    using base_type = std::ratio<(int)Type, 1>;
+    using base_type = BaseDimension<Type>;
     using ratio = std::ratio<1, 1>;
 };
 
@@ -120,13 +375,13 @@ struct MultiUnit : public AbstractUnit<MultiUnit<Ts...>, std::common_type_t<decl
 
     using AbstractUnit<MultiUnit<Ts...>, std::common_type_t<decltype(Ts::value)...>>::AbstractUnit;
 
-    using base_type = typename RecursiveRatioMultiply<typename Ts::base_type...>::ratio;
+    using base_type = typename DimensionProduct<typename Ts::base_type...>::type;
     using ratio = typename RecursiveRatioMultiply<typename Ts::ratio...>::ratio;
 };
 
 template<typename BaseType, typename Ratio=std::ratio<1, 1>, typename Numeric = double>
 struct SpecifiedUnit : public AbstractUnit<SpecifiedUnit<BaseType, Ratio, Numeric>, Numeric> {
-    static_assert(is_ratio_v<BaseType>, "SpecifiedUnit requires a ratio as BaseType (see is_ratio<T>)");
+    static_assert(is_dimension_v<BaseType>, "SpecifiedUnit requires a dimension as BaseType (see is_dimension<T>)");
     static_assert(is_ratio_v<Ratio>, "SpecifiedUnit requires a ratio as Ratio (see is_ratio<T>)");
 
     using AbstractUnit<SpecifiedUnit<BaseType, Ratio, Numeric>, Numeric>::AbstractUnit;
@@ -138,25 +393,9 @@ struct SpecifiedUnit : public AbstractUnit<SpecifiedUnit<BaseType, Ratio, Numeri
 template<typename T, typename Numeric>
 using NumericUnit = SpecifiedUnit<typename T::base_type, typename T::ratio, Numeric>;
 
-template<BaseTypes Type, int ID, typename Numeric = double>
-struct RuntimeUnit {
-    Numeric value;
-    explicit constexpr RuntimeUnit(Numeric v): value(v) {}
-
-    template<typename T, class = typename std::enable_if_t<has_equivalent_base_type_v<T, RuntimeUnit<Type, ID>>>>
-    explicit constexpr RuntimeUnit(T other): value{Unit<Type>{other}.value / ratio::num * ratio::den} {}
-
-    template<typename T, class = typename std::enable_if_t<has_equivalent_base_type_v<T, RuntimeUnit<Type, ID>>>>
-    constexpr operator T() {
-        return T{Unit<Type>{value * ratio::num / ratio::den}};
-    }
-
-    using base_type = std::ratio<(int) Type, 1>;
-    struct ratio {
-        static inline intmax_t num = 1;
-        static inline intmax_t den = 1;
-    };
-};
+// The single type operators produce for a given (dimension, ratio, Numeric), however the operands were spelled
+template<typename BaseType, typename Ratio, typename Numeric>
+using CanonicalUnit = SpecifiedUnit<BaseType, typename std::ratio<Ratio::num, Ratio::den>::type, Numeric>;
 
 template<typename T>
 struct UnitInverse : public AbstractUnit<UnitInverse<T>, decltype(T::value)> {
@@ -164,7 +403,7 @@ struct UnitInverse : public AbstractUnit<UnitInverse<T>, decltype(T::value)> {
 
     using AbstractUnit<UnitInverse<T>, decltype(T::value)>::AbstractUnit;
 
-    using base_type = std::ratio_divide<std::ratio<1, 1>, typename T::base_type>;
+    using base_type = typename DimensionInverse<typename T::base_type>::type;
     using ratio = std::ratio_divide<std::ratio<1, 1>, typename T::ratio>;
 };
 
@@ -187,56 +426,87 @@ struct UnitOffset {
     }
 };
 
+template<typename To, Rounding Round = Rounding::TRUNCATE, typename From, class = typename
+        std::enable_if_t<has_equivalent_base_type_v<To, From>>>
+constexpr To unit_cast(const From& from) {
+    using factor_t = ConversionFactor<typename From::ratio, typename To::ratio>;
+    return To{scale_value<factor_t, decltype(To::value), Round>(from.value)};
+}
+
+// Result of T1 + T2 or T1 - T2: T1's ratio, unless both are integral and T2 is not a whole multiple of T1, in which case
+// the finest ratio both convert to exactly, so integer sums never go through floating point. Values at that ratio are
+// larger by up to its denominator, so its Numeric is at least 64 bits wide
+template<typename T1, typename T2>
+struct SumUnit {
+    static_assert(has_equivalent_base_type_v<T1, T2>, "SumUnit must be passed units of equivalent base type (see has_equivalent_base_type<T1, T2>)");
+private:
+    using T1_ratio = typename T1::ratio;
+    using T2_ratio = typename T2::ratio;
+    static constexpr bool whole_multiple = ConversionFactor<T2_ratio, T1_ratio>::exact && ConversionFactor<T2_ratio, T1_ratio>::den == 1;
+    static constexpr bool integral = std::is_integral_v<decltype(T1::value)> && std::is_integral_v<decltype(T2::value)>;
+public:
+    using type = std::conditional_t<integral && !whole_multiple,
+            CanonicalUnit<typename T1::base_type,
+                    std::ratio<std::gcd(T1_ratio::num, T2_ratio::num), std::lcm(T1_ratio::den, T2_ratio::den)>,
+                    decltype(T1::value + T2::value + std::int64_t{})>,
+            CanonicalUnit<typename T1::base_type, T1_ratio,
+                    std::conditional_t<whole_multiple, decltype(T1::value + T2::value), decltype(T1::value + 1.0 * T2::value)>>>;
+};
+
 template<typename T1, typename T2, class = typename
         std::enable_if_t<is_unit_v<T1> && is_unit_v<T2>>>
-constexpr MultiUnit<T1, T2> operator*(const T1& t1, const T2& t2) {
-    return MultiUnit<T1, T2>{t1.value * t2.value};
+constexpr CanonicalUnit<typename DimensionProduct<typename T1::base_type, typename T2::base_type>::type,
+        std::ratio_multiply<typename T1::ratio, typename T2::ratio>, decltype(T1::value * T2::value)> operator*(const T1& t1, const T2& t2) {
+    return CanonicalUnit<typename DimensionProduct<typename T1::base_type, typename T2::base_type>::type,
+            std::ratio_multiply<typename T1::ratio, typename T2::ratio>, decltype(t1.value * t2.value)>{t1.value * t2.value};
 }
 
 template<typename T1, typename T2, class = typename
         std::enable_if_t<std::is_arithmetic_v<T1> && is_unit_v<T2>>>
-constexpr SpecifiedUnit<typename T2::base_type, typename T2::ratio, decltype(T2::value * T1{})> operator*(const T1& v, const T2& t) {
-    return SpecifiedUnit<typename T2::base_type, typename T2::ratio, decltype(t.value * v)>{t.value * v};
+constexpr CanonicalUnit<typename T2::base_type, typename T2::ratio, decltype(T2::value * T1{})> operator*(const T1& v, const T2& t) {
+    return CanonicalUnit<typename T2::base_type, typename T2::ratio, decltype(t.value * v)>{t.value * v};
 }
 
 template<typename T1, typename T2, class = typename
         std::enable_if_t<std::is_arithmetic_v<T2> && is_unit_v<T1>>>
-constexpr SpecifiedUnit<typename T1::base_type, typename T1::ratio, decltype(T1::value * T2{})> operator*(const T1& t, const T2& v) {
-    return SpecifiedUnit<typename T1::base_type, typename T1::ratio, decltype(t.value * v)>{t.value * v};
+constexpr CanonicalUnit<typename T1::base_type, typename T1::ratio, decltype(T1::value * T2{})> operator*(const T1& t, const T2& v) {
+    return CanonicalUnit<typename T1::base_type, typename T1::ratio, decltype(t.value * v)>{t.value * v};
 }
 
 template<typename T1, typename T2, class = typename
         std::enable_if_t<is_unit_v<T1> && is_unit_v<T2>>>
-constexpr MultiUnit<T1, UnitInverse<T2>> operator/(const T1& t1, const T2& t2) {
-    return MultiUnit<T1, UnitInverse<T2>>{t1.value / t2.value};
+constexpr CanonicalUnit<typename DimensionProduct<typename T1::base_type, typename DimensionInverse<typename T2::base_type>::type>::type,
+        std::ratio_divide<typename T1::ratio, typename T2::ratio>, decltype(T1::value / T2::value)> operator/(const T1& t1, const T2& t2) {
+    return CanonicalUnit<typename DimensionProduct<typename T1::base_type, typename DimensionInverse<typename T2::base_type>::type>::type,
+            std::ratio_divide<typename T1::ratio, typename T2::ratio>, decltype(t1.value / t2.value)>{t1.value / t2.value};
 }
 
 template<typename T1, typename T2, class = typename
         std::enable_if_t<std::is_arithmetic_v<T1> && is_unit_v<T2>>>
-constexpr UnitInverse<SpecifiedUnit<typename T2::base_type, typename T2::ratio, decltype(T1{} / T2::value)>> operator/(const T1& v, const T2& t) {
-    return UnitInverse<SpecifiedUnit<typename T2::base_type, typename T2::ratio, decltype(v / t.value)>>{v / t.value};
+constexpr CanonicalUnit<typename DimensionInverse<typename T2::base_type>::type,
+        std::ratio_divide<std::ratio<1, 1>, typename T2::ratio>, decltype(T1{} / T2::value)> operator/(const T1& v, const T2& t) {
+    return CanonicalUnit<typename DimensionInverse<typename T2::base_type>::type,
+            std::ratio_divide<std::ratio<1, 1>, typename T2::ratio>, decltype(v / t.value)>{v / t.value};
 }
 
 template<typename T1, typename T2, class = typename
         std::enable_if_t<std::is_arithmetic_v<T2> && is_unit_v<T1>>>
-constexpr SpecifiedUnit<typename T1::base_type, typename T1::ratio, decltype(T1::value / T2{})> operator/(const T1& t, const T2& v) {
-    return SpecifiedUnit<typename T1::base_type, typename T1::ratio, decltype(t.value / v)>{t.value / v};
+constexpr CanonicalUnit<typename T1::base_type, typename T1::ratio, decltype(T1::value / T2{})> operator/(const T1& t, const T2& v) {
+    return CanonicalUnit<typename T1::base_type, typename T1::ratio, decltype(t.value / v)>{t.value / v};
 }
 
 template<typename T1, typename T2, class = typename
         std::enable_if_t<has_equivalent_base_type_v<T1, T2>>>
 constexpr auto operator+(const T1& t1, const T2& t2) {
-    using ret_type = SpecifiedUnit<typename T1::base_type, typename T1::ratio,
-            std::conditional_t<std::ratio_divide<typename T2::ratio, typename T1::ratio>::den == 1, decltype(t1.value + t2.value), decltype(t1.value + 1.0 * t2.value)>>;
-    return ret_type{t1.value + ret_type{t2}.value};
+    using ret_type = typename SumUnit<T1, T2>::type;
+    return ret_type{unit_cast<ret_type>(t1).value + unit_cast<ret_type>(t2).value};
 }
 
 template<typename T1, typename T2, class = typename
         std::enable_if_t<has_equivalent_base_type_v<T1, T2>>>
 constexpr auto operator-(const T1& t1, const T2& t2) {
-    using ret_type = SpecifiedUnit<typename T1::base_type, typename T1::ratio,
-            std::conditional_t<std::ratio_divide<typename T2::ratio, typename T1::ratio>::den == 1, decltype(t1.value - t2.value), decltype(t1.value - 1.0 * t2.value)>>;
-    return ret_type{t1.value - ret_type{t2}.value};
+    using ret_type = typename SumUnit<T1, T2>::type;
+    return ret_type{unit_cast<ret_type>(t1).value - unit_cast<ret_type>(t2).value};
 }
 
 #endif //UNITMAKER_UNITS_H